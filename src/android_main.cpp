@@ -51,6 +51,11 @@
 
 // poll mode
 int thd_poll_interval = 4; //in seconds
+// Sensor reads outside of a sampling tick may reuse a value this old
+int thd_sensor_max_staleness = 500; //in msec
+// Replay is not supported
+char *thd_replay_file = nullptr;
+int thd_replay_repeat = 1;
 
 bool thd_ignore_default_control = false;
 bool workaround_enabled = false;
@@ -45,6 +45,7 @@
 #include "thd_engine.h"
 #include "thd_engine_adaptive.h"
 #include "thd_engine_default.h"
+#include "thd_simulator.h"
 #include "thd_parse.h"
 #include <syslog.h>
 
@@ -55,6 +56,7 @@
 #define EXIT_UNSUPPORTED 2
 
 extern int thd_dbus_server_init(gboolean (*exit_handler)(void));
+extern void thd_dbus_set_signal_params(int interval, int temp_delta);
 
 // Lock file
 static int lock_file_handle = -1;
@@ -73,6 +75,18 @@ static gboolean dbus_enable;
 
 // poll mode
 int thd_poll_interval = 4; //in seconds
+// Sensor reads outside of a sampling tick may reuse a value this old
+int thd_sensor_max_staleness = 500; //in msec
+// Drive the engine from a recorded trace instead of sysfs
+char *thd_replay_file = nullptr;
+int thd_replay_repeat = 1;
+// Shared memory telemetry file, updated every engine tick
+bool thd_telemetry_enable = false;
+// Metrics file for the node_exporter textfile collector
+int thd_metrics_interval = 0; //in seconds, 0 disables it
+char *thd_metrics_file = nullptr;
+// Run the controllers against a simulated platform instead
+static gchar *simulate_file = nullptr;
 
 bool thd_ignore_default_control = false;
 bool workaround_enabled = false;
@@ -91,15 +105,13 @@ static GMainLoop *g_main_loop;
 gint own_id = 0;
 #endif
 
-// g_log handler. All logs will be directed here
-void thd_logger(const gchar *log_domain, GLogLevelFlags log_level,
-		const gchar *message, gpointer user_data) {
+// Output of the g_log handler and of the log ring drainer
+static void thd_log_write(int log_level, time_t seconds, const char *message) {
 	if (!(thd_log_level & log_level))
 		return;
 
 	int syslog_priority;
 	const char *prefix;
-	time_t seconds;
 
 	switch (log_level) {
 	case G_LOG_LEVEL_ERROR:
@@ -129,15 +141,28 @@ void thd_logger(const gchar *log_domain, GLogLevelFlags log_level,
 		break;
 	}
 
-	seconds = time(nullptr);
-
 	if (use_syslog)
 		syslog(syslog_priority, "%s", message);
+	else if (thd_replay_file || simulate_file) // stdout has the results
+		g_printerr("[%lld]%s%s", (long long) seconds, prefix, message);
 	else
 		g_print("[%lld]%s%s", (long long) seconds, prefix, message);
 
 }
 
+// g_log handler. All logs will be directed here
+void thd_logger(const gchar *log_domain, GLogLevelFlags log_level,
+		const gchar *message, gpointer user_data) {
+	if (!(thd_log_level & log_level))
+		return;
+
+	// Deferred info and debug lines logged before this one go first
+	if (log_level & ~(G_LOG_LEVEL_INFO | G_LOG_LEVEL_DEBUG))
+		thd_log_ring_flush();
+
+	thd_log_write(log_level, time(nullptr), message);
+}
+
 void clean_up_lockfile(void) {
 	if (lock_file_handle != -1) {
 		(void) close(lock_file_handle);
@@ -178,6 +203,14 @@ gboolean sig_int_handler(void) {
 	return FALSE;
 }
 
+// SIGUSR1 handler: dump engine stats to the log
+gboolean sig_usr1_handler(void) {
+	if (thd_engine)
+		thd_engine->thd_engine_log_stats();
+
+	return G_SOURCE_CONTINUE;
+}
+
 gboolean log_debug = FALSE;
 
 // main function
@@ -189,8 +222,14 @@ int main(int argc, char *argv[]) {
 	gboolean test_mode = FALSE;
 	gboolean adaptive = FALSE;
 	gboolean ignore_default_control = FALSE;
+	gboolean telemetry = FALSE;
 	gchar *conf_file = nullptr;
 	gint poll_interval = -1;
+	gint sensor_max_staleness = -1;
+	gint replay_repeat = 1;
+	gchar *sysfs_root = nullptr;
+	gint dbus_signal_interval = -1;
+	gint dbus_temp_delta = -1;
 	gboolean success;
 	GOptionContext *opt_ctx;
 	int ret;
@@ -215,8 +254,19 @@ int main(int argc, char *argv[]) {
 			{ "poll-interval", 0, 0, G_OPTION_ARG_INT, &poll_interval,
 					N_("Poll interval in seconds: Poll for zone temperature changes. "
 						"If want to disable polling set to zero."), nullptr },
+			{ "sensor-max-staleness", 0, 0, G_OPTION_ARG_INT,
+					&sensor_max_staleness, N_("Max age in msec of a cached "
+						"sensor reading for reads outside of a sampling cycle. "
+						"Default is 500."), nullptr },
 			{ "dbus-enable", 0, 0, G_OPTION_ARG_NONE, &dbus_enable, N_(
-					"Enable Dbus."), nullptr }, { "exclusive-control", 0, 0,
+					"Enable Dbus."), nullptr },
+			{ "dbus-signal-interval", 0, 0, G_OPTION_ARG_INT,
+					&dbus_signal_interval, N_("Min msec between Dbus change "
+						"signals, 0 disables them. Default is 1000."), nullptr },
+			{ "dbus-temp-delta", 0, 0, G_OPTION_ARG_INT, &dbus_temp_delta,
+					N_("Temperature change in mC for a TemperatureChanged "
+						"signal. Default is 1000."), nullptr },
+			{ "exclusive-control", 0, 0,
 							G_OPTION_ARG_NONE, &exclusive_control, N_(
 							"Take over thermal control from kernel thermal driver."),
 								nullptr },
@@ -239,6 +289,30 @@ int main(int argc, char *argv[]) {
 			{ "power-floor-enable", 0, 0, G_OPTION_ARG_NONE,
 						&power_floor_enable, N_(
 						"Handle power floor event"), nullptr },
+			{ "replay", 0, 0, G_OPTION_ARG_FILENAME, &thd_replay_file, N_(
+						"Replay sensor samples from a thermald trace file "
+						"without changing cooling devices, then exit"), nullptr },
+			{ "replay-repeat", 0, 0, G_OPTION_ARG_INT, &replay_repeat, N_(
+						"Number of times to replay the trace. Default is 1."),
+						nullptr },
+			{ "simulate", 0, 0, G_OPTION_ARG_FILENAME, &simulate_file, N_(
+						"Run the thermal controllers against a simulated "
+						"platform described in a scenario file, then exit"),
+						nullptr },
+			{ "sysfs-root", 0, 0, G_OPTION_ARG_FILENAME, &sysfs_root, N_(
+						"Look up /sys paths below this directory, for testing "
+						"with a generated sysfs tree"), nullptr },
+			{ "telemetry", 0, 0, G_OPTION_ARG_NONE, &telemetry,
+						N_("Write the current values to "
+						TDRUNDIR "/thermald.telemetry on every engine tick"),
+						nullptr },
+			{ "metrics-interval", 0, 0, G_OPTION_ARG_INT,
+						&thd_metrics_interval, N_("Write metrics for the "
+						"node_exporter textfile collector every N seconds. "
+						"Default is 0, disabled."), nullptr },
+			{ "metrics-file", 0, 0, G_OPTION_ARG_FILENAME, &thd_metrics_file,
+						N_("Metrics file. Default is "
+						TDRUNDIR "/thermald.prom"), nullptr },
 			{ nullptr, 0, 0,
 					G_OPTION_ARG_NONE, nullptr, nullptr, nullptr } };
 
@@ -307,8 +381,36 @@ int main(int argc, char *argv[]) {
 		fprintf(stdout, "Polling enabled: %d\n", poll_interval);
 		thd_poll_interval = poll_interval;
 	}
+	if (sensor_max_staleness >= 0)
+		thd_sensor_max_staleness = sensor_max_staleness;
+	if (thd_replay_file) {
+		// Foreground, no D-Bus and no changes to the running system
+		thd_replay_repeat = replay_repeat > 0 ? replay_repeat : 1;
+		no_daemon = TRUE;
+		systemd = FALSE;
+		dbus_enable = FALSE;
+		csys_fs::set_dry_run(true);
+	}
+	if (simulate_file) {
+		no_daemon = TRUE;
+		systemd = FALSE;
+		dbus_enable = FALSE;
+		csys_fs::set_dry_run(true);
+	}
+
+	if (sysfs_root) {
+		csys_fs::set_root(sysfs_root);
+		// Trace, telemetry and crash dump of this instance go there too
+		std::string run_dir = csys_fs::map_path(TDRUNDIR "/");
+		if (g_mkdir_with_parents(run_dir.c_str(), 0755) != 0) {
+			fprintf(stderr, "Cannot create '%s': %s\n", run_dir.c_str(),
+					strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
 
 	thd_ignore_default_control = ignore_default_control;
+	thd_telemetry_enable = telemetry;
 
 	openlog("thermald", LOG_PID, LOG_USER | LOG_DAEMON | LOG_SYSLOG);
 	// Don't care return val
@@ -316,8 +418,11 @@ int main(int argc, char *argv[]) {
 	thd_daemonize = !no_daemon && !systemd;
 	use_syslog = !no_daemon || systemd;
 	g_log_set_handler(nullptr, G_LOG_LEVEL_MASK, thd_logger, nullptr);
+	thd_log_ring_init(thd_log_level, thd_log_write);
 
-	if (check_thermald_running()) {
+	// An instance on a generated tree runs next to the system one
+	if (!thd_replay_file && !simulate_file && !sysfs_root
+			&& check_thermald_running()) {
 		thd_log_error(
 				"An instance of thermald is already running, exiting ...\n");
 		exit(EXIT_FAILURE);
@@ -336,8 +441,10 @@ int main(int argc, char *argv[]) {
 		return THD_FATAL_ERROR;
 	}
 
-	if (dbus_enable)
+	if (dbus_enable) {
+		thd_dbus_set_signal_params(dbus_signal_interval, dbus_temp_delta);
 		thd_dbus_server_init(sig_int_handler);
+	}
 
 	if (thd_daemonize) {
 		printf("Ready to serve requests: Daemonizing.. %d\n", thd_daemonize);
@@ -352,6 +459,15 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	if (thd_log_ring_start() != THD_SUCCESS)
+		thd_log_warn("Failed to start log drainer\n");
+
+	if (simulate_file) {
+		ret = thd_engine_create_simulator_engine(simulate_file);
+		closelog();
+		exit(ret == THD_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	if (adaptive) {
 		ret = thd_engine_create_adaptive_engine((bool) ignore_cpuid_check, (bool) test_mode);
 		if (ret != THD_SUCCESS) {
@@ -374,6 +490,16 @@ int main(int argc, char *argv[]) {
 			exit(EXIT_FAILURE);
 	}
 
+	// Replay ran to completion in thd_engine_start()
+	if (thd_replay_file) {
+		clean_up_lockfile();
+		closelog();
+		exit(EXIT_SUCCESS);
+	}
+
+	// After daemon(), as the signal source needs the GLib worker thread
+	g_unix_signal_add(SIGUSR1, G_SOURCE_FUNC(sig_usr1_handler), nullptr);
+
 	// Start service requests on the D-Bus
 	thd_log_debug("Start main loop\n");
 	g_main_loop_run(g_main_loop);
@@ -38,6 +38,7 @@
 
 #include "thd_cdev.h"
 #include "thd_engine.h"
+#include "thd_util.h"
 
 // Clamp to cdev min state or trip specific min if valid
 int cthd_cdev::thd_clamp_state_min(int _state, int temp_min_state, int temp_max_state)
@@ -262,7 +263,9 @@ int cthd_cdev::thd_cdev_set_state(int set_point, int target_temp,
 		cthd_pid &pid, bool force, int min_max_valid, int _min_state,
 		int _max_state) {
 
-	time_t tm;
+	cthd_stat_timer timer(thd_engine->get_stats(), STAT_CDEV);
+	int prev_state = curr_state;
+	long long tm;
 	int ret;
 
 	if (!state && in_min_state() && zone_trip_limits.size() == 0) {
@@ -272,7 +275,7 @@ int cthd_cdev::thd_cdev_set_state(int set_point, int target_temp,
 		return THD_SUCCESS;
 	}
 
-	time(&tm);
+	tm = thd_get_monotonic_msec();
 
 	thd_log_debug(
 			">>thd_cdev_set_state temperature %d:%d index:%d state:%d :zone:%d trip_id:%d target_state_valid:%d target_value :%d force:%d min_state:%d max_state:%d\n",
@@ -382,7 +385,7 @@ int cthd_cdev::thd_cdev_set_state(int set_point, int target_temp,
 		}
 
 		if (!force && last_state == state && state
-			&& (tm - last_action_time) <= debounce_interval) {
+			&& (tm - last_action_time) <= debounce_interval * 1000LL) {
 			thd_log_debug(
 				"Ignore: delay < debounce interval : %d, %d, %d, %d, %d\n",
 				set_point, temperature, index, get_curr_state(), max_state);
@@ -533,6 +536,10 @@ int cthd_cdev::thd_cdev_set_state(int set_point, int target_temp,
 		control_end();
 	}
 
+	// Not get_curr_state(), which may read back from sysfs
+	if (curr_state != prev_state)
+		thd_engine->cdev_state_changed(this, zone_id, curr_state);
+
 	return ret;
 }
 
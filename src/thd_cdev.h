@@ -26,6 +26,7 @@
 #define THD_CDEV_H
 
 #include <time.h>
+#include <atomic>
 #include <vector>
 #include "thd_common.h"
 #include "thd_sys_fs.h"
@@ -77,7 +78,7 @@ protected:
 	std::string type_str;
 	std::string alias_str;
 	int debounce_interval;
-	time_t last_action_time;
+	long long last_action_time; // Monotonic msec
 	bool trend_increase;
 	bool pid_enable;
 	cthd_pid pid_ctrl;
@@ -86,6 +87,15 @@ protected:
 	std::string write_prefix;
 	int inc_val;
 	int dec_val;
+	std::atomic<unsigned long> sysfs_writes;
+	std::atomic<unsigned long> sysfs_write_errors;
+
+	// Count a state write for the engine stats, ret from sysfs write
+	void count_sysfs_write(int ret) {
+		sysfs_writes.fetch_add(1, std::memory_order_relaxed);
+		if (ret <= 0)
+			sysfs_write_errors.fetch_add(1, std::memory_order_relaxed);
+	}
 
 private:
 	unsigned int int_2_pow(int pow) {
@@ -109,7 +119,8 @@ public:
 					0), inc_dec_val(1), auto_down_adjust(false), read_back(
 					true), debounce_interval(default_debounce_interval), last_action_time(
 					0), trend_increase(false), pid_enable(false), pid_ctrl(), last_state(
-					0), write_prefix(""), inc_val(0), dec_val(0) {
+					0), write_prefix(""), inc_val(0), dec_val(0), sysfs_writes(0), sysfs_write_errors(
+					0) {
 	}
 
 	virtual ~cthd_cdev() {
@@ -122,6 +133,13 @@ public:
 
 	virtual int thd_cdev_set_min_state(int zone_id, int trip_id);
 
+	unsigned long get_sysfs_writes() {
+		return sysfs_writes.load(std::memory_order_relaxed);
+	}
+	unsigned long get_sysfs_write_errors() {
+		return sysfs_write_errors.load(std::memory_order_relaxed);
+	}
+
 	virtual void thd_cdev_set_min_state_param(int arg) {
 		min_state = arg;
 	}
@@ -179,6 +197,11 @@ public:
 		return max_state;
 	}
 
+	// States are power limits in uW
+	virtual bool is_power_limit() {
+		return false;
+	}
+
 	virtual int update() {
 		return 0;
 	}
@@ -245,7 +268,7 @@ public:
 		return 0;
 	}
 
-	std::string get_cdev_type() {
+	const std::string &get_cdev_type() {
 		return type_str;
 	}
 	std::string get_cdev_alias() {
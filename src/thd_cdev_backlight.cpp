@@ -119,6 +119,7 @@ void cthd_cdev_backlight::set_curr_state(int state, int arg) {
 	}
 
 	ret = cdev_sysfs.write("brightness", backlight_val);
+	count_sysfs_write(ret);
 	if (ret < 0) {
 		thd_log_warn("Failed to write brightness\n");
 		return;
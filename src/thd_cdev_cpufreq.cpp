@@ -69,7 +69,7 @@ int cthd_cdev_cpufreq::init() {
 		std::string p =
 				"/sys/devices/system/cpu/cpu0/cpufreq/scaling_available_frequencies";
 
-		std::ifstream f(p.c_str(), std::fstream::in);
+		std::ifstream f(csys_fs::map_path(p).c_str(), std::fstream::in);
 		if (f.fail())
 			return -EINVAL;
 
@@ -141,6 +141,17 @@ int cthd_cdev_cpufreq::init() {
 	if (cpufreqs.size())
 		max_state = cpufreqs.size() - 1;
 
+	max_freq_attrs.clear();
+	for (int i = cpu_start_index; i <= cpu_end_index; ++i) {
+		std::ostringstream str;
+		std::unique_ptr<csys_fs_attr> attr(new csys_fs_attr());
+
+		str << "cpu" << i << "/cpufreq/scaling_max_freq";
+		if (cdev_sysfs.exists(str.str()))
+			attr->open(cdev_sysfs.get_base_path() + str.str(), O_RDWR);
+		max_freq_attrs.push_back(std::move(attr));
+	}
+
 	pstate_active_freq_index = 0;
 
 	return THD_SUCCESS;
@@ -156,6 +167,16 @@ void cthd_cdev_cpufreq::add_frequency(unsigned int freq_int) {
 	}
 }
 
+void cthd_cdev_cpufreq::write_max_freq(int cpu, int freq) {
+	int i = cpu - cpu_start_index;
+
+	if (i < 0 || i >= (int) max_freq_attrs.size())
+		return;
+
+	if (max_freq_attrs[i]->is_open())
+		count_sysfs_write(max_freq_attrs[i]->write(freq));
+}
+
 void cthd_cdev_cpufreq::set_curr_state(int state, int arg) {
 
 	if (state >=0 && state < (int) cpufreqs.size()) {
@@ -164,25 +185,13 @@ void cthd_cdev_cpufreq::set_curr_state(int state, int arg) {
 
 		if (cpu_index == -1) {
 			for (int i = cpu_start_index; i <= cpu_end_index; ++i) {
-				std::ostringstream str;
-				str << "cpu" << i << "/cpufreq/scaling_max_freq";
-				if (cdev_sysfs.exists(str.str())) {
-					std::ostringstream speed;
-					speed << cpufreqs[state];
-					cdev_sysfs.write(str.str(), speed.str());
-				}
+				write_max_freq(i, cpufreqs[state]);
 				pstate_active_freq_index = state;
 				curr_state = state;
 			}
 		} else {
 			if (thd_engine->apply_cpu_operation(cpu_index)) {
-				std::ostringstream str;
-				str << "cpu" << cpu_index << "/cpufreq/scaling_max_freq";
-				if (cdev_sysfs.exists(str.str())) {
-					std::ostringstream speed;
-					speed << cpufreqs[state];
-					cdev_sysfs.write(str.str(), speed.str());
-				}
+				write_max_freq(cpu_index, cpufreqs[state]);
 				pstate_active_freq_index = state;
 				curr_state = state;
 			}
@@ -25,6 +25,7 @@
 #ifndef THD_CDEV_PSTATES_H_
 #define THD_CDEV_PSTATES_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "thd_cdev.h"
@@ -38,8 +39,11 @@ private:
 	int pstate_active_freq_index;
 	std::string last_governor;
 	int cpu_index;
+	// scaling_max_freq per CPU from cpu_start_index, opened in init()
+	std::vector<std::unique_ptr<csys_fs_attr>> max_freq_attrs;
 
 	void add_frequency(unsigned int freq_int);
+	void write_max_freq(int cpu, int freq);
 
 public:
 	cthd_cdev_cpufreq(unsigned int _index, int _cpu_index) :
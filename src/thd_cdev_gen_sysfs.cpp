@@ -58,7 +58,7 @@ void cthd_gen_sysfs_cdev::set_curr_state(int state, int arg) {
 	state_str << state;
 	thd_log_debug("set cdev state index %d state %d %s\n", index, state,
 			state_str.str().c_str());
-	cdev_sysfs.write("", state_str.str());
+	count_sysfs_write(cdev_sysfs.write("", state_str.str()));
 	curr_state = state;
 }
 
@@ -55,7 +55,9 @@ void cthd_intel_p_state_cdev::set_curr_state(int state, int arg) {
 			set_turbo_disable_status(true);
 		else
 			set_turbo_disable_status(false);
-		if (cdev_sysfs.write(tc_state_dev.str(), state_str.str()) < 0)
+		int ret = cdev_sysfs.write(tc_state_dev.str(), state_str.str());
+		count_sysfs_write(ret);
+		if (ret < 0)
 			curr_state = (state == 0) ? 0 : max_state;
 		else
 			curr_state = state;
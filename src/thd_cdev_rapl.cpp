@@ -108,10 +108,13 @@ int cthd_sysfs_cdev_rapl::get_curr_state() {
 // Return the current power, using this the controller can choose the next state
 int cthd_sysfs_cdev_rapl::get_curr_state(bool read_again) {
 	if (dynamic_phy_max_enable) {
-		int pl1, power;
+		rapl_power_snapshot_t snapshot;
+		int pl1, power = 0;
 
 		thd_engine->rapl_power_meter.rapl_start_measure_power();
-		power = thd_engine->rapl_power_meter.rapl_action_get_power(PACKAGE);
+		if (thd_engine->rapl_power_meter.rapl_get_power_snapshot(PACKAGE,
+				&snapshot))
+			power = snapshot.power;
 		pl1 = rapl_read_pl1();
 		if (pl1 != THD_ERROR && pl1 < power)
 			return pl1;
@@ -161,6 +164,8 @@ int cthd_sysfs_cdev_rapl::rapl_sysfs_valid()
 				temp_str.str().c_str());
 		return THD_ERROR;
 	}
+	// PL1 is read and written on every state change, keep it open
+	pl1_attr.open(cdev_sysfs.get_base_path() + temp_str.str(), O_RDWR);
 
 	temp_str.str(std::string());
 	temp_str << "constraint_" << constraint_index << "_time_window_us";
@@ -188,9 +193,17 @@ int cthd_sysfs_cdev_rapl::rapl_read_pl1_max()
 
 int cthd_sysfs_cdev_rapl::rapl_read_pl1()
 {
-	std::ostringstream temp_power_str;
 	int current_pl1;
 
+	if (pl1_attr.is_open()) {
+		if (pl1_attr.read(&current_pl1) > 0)
+			return current_pl1;
+
+		return THD_ERROR;
+	}
+
+	std::ostringstream temp_power_str;
+
 	temp_power_str << "constraint_" << constraint_index << "_power_limit_uw";
 	if (cdev_sysfs.read(temp_power_str.str(), &current_pl1) > 0) {
 		return current_pl1;
@@ -201,11 +214,17 @@ int cthd_sysfs_cdev_rapl::rapl_read_pl1()
 
 int cthd_sysfs_cdev_rapl::rapl_update_pl1(int pl1)
 {
-	std::ostringstream temp_power_str;
 	int ret;
 
-	temp_power_str << "constraint_" << constraint_index << "_power_limit_uw";
-	ret = cdev_sysfs.write(temp_power_str.str(), pl1);
+	if (pl1_attr.is_open()) {
+		ret = pl1_attr.write(pl1);
+	} else {
+		std::ostringstream temp_power_str;
+
+		temp_power_str << "constraint_" << constraint_index << "_power_limit_uw";
+		ret = cdev_sysfs.write(temp_power_str.str(), pl1);
+	}
+	count_sysfs_write(ret);
 	if (ret <= 0) {
 		thd_log_info(
 				"pkg_power: powercap RAPL max power limit failed to write %d\n",
@@ -52,6 +52,7 @@ protected:
 	int power_on_constraint_0_time_window;
 	int power_on_enable_status;
 	std::string device_name;
+	csys_fs_attr pl1_attr;
 	virtual bool read_ppcc_power_limits();
 
 private:
@@ -111,6 +112,9 @@ public:
 	int get_phy_max_state() override {
 		return phy_max;
 	}
+	bool is_power_limit() override {
+		return true;
+	}
 	int rapl_update_enable_status(int enable);
 };
 
@@ -33,7 +33,7 @@ int cthd_sysfs_cdev_rapl_dram::update() {
 	bool found = false;
 	std::string path_name;
 
-	dir = opendir(base.c_str());
+	dir = opendir(csys_fs::map_path(base).c_str());
 	if (!dir)
 		return THD_ERROR;
 
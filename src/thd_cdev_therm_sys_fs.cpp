@@ -38,8 +38,12 @@ int cthd_sysfs_cdev::update() {
 		int ret = cdev_sysfs.read(tc_state_dev.str(), &curr_state);
 		if (ret < 0)
 			return ret;
-	} else
+		cur_state_attr.open(cdev_sysfs.get_base_path() + tc_state_dev.str(),
+				O_RDWR);
+	} else {
+		cur_state_attr.close();
 		curr_state = 0;
+	}
 
 	std::ostringstream tc_max_state_dev;
 	tc_max_state_dev << "cooling_device" << index << "/max_state";
@@ -47,8 +51,12 @@ int cthd_sysfs_cdev::update() {
 		int ret = cdev_sysfs.read(tc_max_state_dev.str(), &max_state);
 		if (ret < 0)
 			return ret;
-	} else
+		max_state_attr.open(cdev_sysfs.get_base_path()
+				+ tc_max_state_dev.str());
+	} else {
+		max_state_attr.close();
 		max_state = 0;
+	}
 
 	std::ostringstream tc_type_dev;
 	tc_type_dev << "cooling_device" << index << "/type";
@@ -71,6 +79,13 @@ int cthd_sysfs_cdev::update() {
 
 int cthd_sysfs_cdev::get_max_state() {
 
+	// Read on every trip check, drivers may change it
+	if (max_state_attr.is_open()) {
+		int ret = max_state_attr.read(&max_state);
+		if (ret < 0)
+			return ret;
+		return max_state;
+	}
 	std::ostringstream tc_state_dev;
 	tc_state_dev << "cooling_device" << index << "/max_state";
 	if (cdev_sysfs.exists(tc_state_dev.str())) {
@@ -85,13 +100,20 @@ int cthd_sysfs_cdev::get_max_state() {
 
 void cthd_sysfs_cdev::set_curr_state(int state, int arg) {
 
+	if (cur_state_attr.is_open()) {
+		thd_log_debug("set cdev state index %d state %d\n", index, state);
+		count_sysfs_write(cur_state_attr.write(state));
+		curr_state = state;
+		return;
+	}
+
 	std::ostringstream tc_state_dev;
 	tc_state_dev << "cooling_device" << index << "/cur_state";
 	if (cdev_sysfs.exists(tc_state_dev.str())) {
 		std::ostringstream state_str;
 		state_str << state;
 		thd_log_debug("set cdev state index %d state %d\n", index, state);
-		cdev_sysfs.write(tc_state_dev.str(), state_str.str());
+		count_sysfs_write(cdev_sysfs.write(tc_state_dev.str(), state_str.str()));
 		curr_state = state;
 	} else
 		curr_state = 0;
@@ -102,6 +124,12 @@ int cthd_sysfs_cdev::get_curr_state() {
 	if (!read_back) {
 		return curr_state;
 	}
+	if (cur_state_attr.is_open()) {
+		int ret = cur_state_attr.read(&curr_state);
+		if (ret < 0)
+			return ret;
+		return curr_state;
+	}
 	std::ostringstream tc_state_dev;
 	tc_state_dev << "cooling_device" << index << "/cur_state";
 	if (cdev_sysfs.exists(tc_state_dev.str())) {
@@ -29,6 +29,8 @@
 
 class cthd_sysfs_cdev: public cthd_cdev {
 protected:
+	csys_fs_attr cur_state_attr;
+	csys_fs_attr max_state_attr;
 
 public:
 	cthd_sysfs_cdev(unsigned int _index, std::string control_path) :
@@ -190,12 +190,18 @@ void cthd_cpu_default_binding::update_zone_stat(std::string zone_name,
 }
 
 bool cthd_cpu_default_binding::check_cpu_load() {
+	rapl_power_snapshot_t snapshot;
 	unsigned int max_power = 0;
 	unsigned int min_power = 0;
-	unsigned int power;
-
-	power = thd_engine->rapl_power_meter.rapl_action_get_power(PACKAGE,
-			&max_power, &min_power);
+	unsigned int power = 0;
+
+	// Never wait for a power reading here, the engine lock is held
+	if (thd_engine->rapl_power_meter.rapl_get_power_snapshot(PACKAGE,
+			&snapshot)) {
+		power = snapshot.power;
+		max_power = snapshot.max_power;
+		min_power = snapshot.min_power;
+	}
 
 	if (cpu_package_max_power != 0)
 		max_power = cpu_package_max_power;
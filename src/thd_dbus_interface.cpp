@@ -114,6 +114,26 @@ gboolean thd_dbus_interface_get_cdev_information(PrefObject *obj, gint index,
 		gchar **cdev_out, gint *min_state, gint *max_state, gint *curr_state,
 		GError **error);
 
+gboolean thd_dbus_interface_get_engine_stats(PrefObject *obj,
+		gchar **stats_out, GError **error);
+
+gboolean thd_dbus_interface_get_thermal_snapshot(PrefObject *obj,
+		GVariant **snapshot_out, GError **error);
+
+// Change signals are sent at most once per interval with the changes since
+// the values sent last, so a burst of changes within an interval coalesces.
+// The engine schedules them when it publishes changed values, nothing runs
+// while values don't change.
+static guint signal_interval = 1000; // msec, 0 disables signals
+static guint signal_temp_delta = 1000; // mC
+
+void thd_dbus_set_signal_params(int interval, int temp_delta) {
+	if (interval >= 0)
+		signal_interval = interval;
+	if (temp_delta > 0)
+		signal_temp_delta = temp_delta;
+}
+
 // To be implemented
 gboolean thd_dbus_interface_add_trip_point(PrefObject *obj, gchar *name,
 		GError **error) {
@@ -301,52 +321,65 @@ gboolean thd_dbus_interface_add_virtual_sensor(PrefObject *obj, gchar *name,
 		return FALSE;
 }
 
+// Readers below answer from the last published engine snapshot, never from
+// the engine objects, which the engine thread changes and reloads
+static std::shared_ptr<const cthd_engine_snapshot> thd_dbus_get_snapshot(
+		GError **error) {
+	std::shared_ptr<const cthd_engine_snapshot> snap;
+
+	if (thd_engine)
+		snap = thd_engine->get_snapshot();
+	if (!snap)
+		g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+				"No thermal snapshot yet");
+
+	return snap;
+}
+
+static char *thd_dbus_reply_str(const std::string &str) {
+	return g_strndup(str.c_str(), MAX_DBUS_REPLY_STR_LEN);
+}
+
 gboolean thd_dbus_interface_get_sensor_information(PrefObject *obj, gint index,
 		gchar **sensor_out, gchar **path, gint *temp, GError **error) {
-	char *sensor_str;
-	char *path_str;
-
 	thd_log_debug("thd_dbus_interface_get_sensor_information %d\n", index);
 
-	cthd_sensor *sensor = thd_engine->user_get_sensor(index);
-	if (!sensor)
-		return FALSE;
-
-	sensor_str = g_new(char, MAX_DBUS_REPLY_STR_LEN + 1);
-	if (!sensor_str)
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
 		return FALSE;
 
-	path_str = g_new(char, MAX_DBUS_REPLY_STR_LEN + 1);
-	if (!path_str) {
-		g_free(sensor_str);
+	const cthd_snapshot_layout &layout = *snap->layout;
+	if (index < 0 || index >= (gint) layout.sensors.size())
 		return FALSE;
-	}
 
-	strncpy(sensor_str, sensor->get_sensor_type().c_str(),
-	MAX_DBUS_REPLY_STR_LEN);
-	sensor_str[MAX_DBUS_REPLY_STR_LEN] = '\0';
-	strncpy(path_str, sensor->get_sensor_path().c_str(),
-	MAX_DBUS_REPLY_STR_LEN);
-	path_str[MAX_DBUS_REPLY_STR_LEN] = '\0';
-	*temp = (gint) sensor->read_temperature();
-	*sensor_out = sensor_str;
-	*path = path_str;
+	*sensor_out = thd_dbus_reply_str(layout.sensors[index].type);
+	*path = thd_dbus_reply_str(layout.sensors[index].path);
+	*temp = (gint) snap->sensor_temps[index];
 
 	return TRUE;
 }
 
 gboolean thd_dbus_interface_get_sensor_count(PrefObject *obj, int *count,
 		GError **error) {
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
 
-	*count = thd_engine->get_sensor_count();
+	*count = snap->layout->sensors.size();
 
 	return TRUE;
 }
 
 gboolean thd_dbus_interface_get_zone_count(PrefObject *obj, int *count,
 		GError **error) {
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
 
-	*count = thd_engine->get_zone_count();
+	*count = snap->layout->zones.size();
 
 	return TRUE;
 }
@@ -354,52 +387,46 @@ gboolean thd_dbus_interface_get_zone_count(PrefObject *obj, int *count,
 gboolean thd_dbus_interface_get_zone_information(PrefObject *obj, gint index,
 		gchar **zone_out, gint *sensor_count, gint *trip_count, gint *bound,
 		GError **error) {
-	char *zone_str;
-
 	thd_log_debug("thd_dbus_interface_get_zone_information %d\n", index);
 
-	cthd_zone *zone = thd_engine->user_get_zone(index);
-	if (!zone)
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
 		return FALSE;
 
-	zone_str = g_new(char, MAX_DBUS_REPLY_STR_LEN + 1);
-	if (!zone_str)
+	const cthd_snapshot_layout &layout = *snap->layout;
+	if (index < 0 || index >= (gint) layout.zones.size())
 		return FALSE;
 
-	strncpy(zone_str, zone->get_zone_type().c_str(),
-	MAX_DBUS_REPLY_STR_LEN);
-	zone_str[MAX_DBUS_REPLY_STR_LEN] = '\0';
-	*zone_out = zone_str;
-	*sensor_count = zone->get_sensor_count();
-	*trip_count = zone->get_trip_count();
-	*bound = (gint) zone->zone_active_status();
+	const thd_snapshot_zone_t &zone = layout.zones[index];
+	*zone_out = thd_dbus_reply_str(zone.type);
+	*sensor_count = zone.sensors.size();
+	*trip_count = zone.trips.size();
+	*bound = (gint) snap->zone_active[index];
+
 	return TRUE;
 }
 
 gboolean thd_dbus_interface_get_zone_sensor_at_index(PrefObject *obj,
 		gint zone_index, gint sensor_index, gchar **sensor_out,
 		GError **error) {
-	char *sensor_str;
-
 	thd_log_debug("thd_dbus_interface_get_zone_sensor_at_index %d\n",
 			zone_index);
 
-	cthd_zone *zone = thd_engine->user_get_zone(zone_index);
-	if (!zone)
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
 		return FALSE;
 
-	cthd_sensor *sensor = zone->get_sensor_at_index(sensor_index);
-	if (!sensor)
+	const cthd_snapshot_layout &layout = *snap->layout;
+	if (zone_index < 0 || zone_index >= (gint) layout.zones.size())
 		return FALSE;
 
-	sensor_str = g_new(char, MAX_DBUS_REPLY_STR_LEN + 1);
-	if (!sensor_str)
+	const thd_snapshot_zone_t &zone = layout.zones[zone_index];
+	if (sensor_index < 0 || sensor_index >= (gint) zone.sensors.size())
 		return FALSE;
 
-	strncpy(sensor_str, sensor->get_sensor_type().c_str(),
-	MAX_DBUS_REPLY_STR_LEN);
-	sensor_str[MAX_DBUS_REPLY_STR_LEN] = '\0';
-	*sensor_out = sensor_str;
+	*sensor_out = thd_dbus_reply_str(zone.sensors[sensor_index]);
 
 	return TRUE;
 }
@@ -407,32 +434,33 @@ gboolean thd_dbus_interface_get_zone_sensor_at_index(PrefObject *obj,
 gboolean thd_dbus_interface_get_zone_trip_at_index(PrefObject *obj,
 		gint zone_index, gint trip_index, int *temp, int *trip_type,
 		int *sensor_id, int *cdev_size, GArray **cdev_ids, GError **error) {
-	thd_log_debug("thd_dbus_interface_get_zone_sensor_at_index %d\n",
+	thd_log_debug("thd_dbus_interface_get_zone_trip_at_index %d\n",
 			zone_index);
 
-	cthd_zone *zone = thd_engine->user_get_zone(zone_index);
-	if (!zone)
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
+
+	const cthd_snapshot_layout &layout = *snap->layout;
+	if (zone_index < 0 || zone_index >= (gint) layout.zones.size())
 		return FALSE;
 
-	cthd_trip_point *trip = zone->get_trip_at_index(trip_index);
-	if (!trip)
+	const thd_snapshot_zone_t &zone = layout.zones[zone_index];
+	if (trip_index < 0 || trip_index >= (gint) zone.trips.size())
 		return FALSE;
 
-	*temp = trip->get_trip_temp();
-	*trip_type = trip->get_trip_type();
-	*sensor_id = trip->get_sensor_id();
-	*cdev_size = trip->get_cdev_count();
+	const thd_snapshot_trip_t &trip = zone.trips[trip_index];
+	*temp = snap->trip_temps[zone.first_trip + trip_index];
+	*trip_type = trip.type;
+	*sensor_id = trip.sensor_id;
+	*cdev_size = trip.cdev_ids.size();
 
 	GArray *garray;
 
 	garray = g_array_new(FALSE, FALSE, sizeof(gint));
-	for (int i = 0; i < *cdev_size; i++) {
-		trip_pt_cdev_t cdev_trip;
-		int index;
-		cdev_trip = trip->get_cdev_at_index(i);
-		index = cdev_trip.cdev->thd_cdev_get_index();
+	for (int index : trip.cdev_ids)
 		g_array_prepend_val(garray, index);
-	}
 
 	*cdev_ids = garray;
 
@@ -441,8 +469,12 @@ gboolean thd_dbus_interface_get_zone_trip_at_index(PrefObject *obj,
 
 gboolean thd_dbus_interface_get_cdev_count(PrefObject *obj, int *count,
 		GError **error) {
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
 
-	*count = thd_engine->get_cdev_count();
+	*count = snap->layout->cdevs.size();
 
 	return TRUE;
 }
@@ -450,26 +482,101 @@ gboolean thd_dbus_interface_get_cdev_count(PrefObject *obj, int *count,
 gboolean thd_dbus_interface_get_cdev_information(PrefObject *obj, gint index,
 		gchar **cdev_out, gint *min_state, gint *max_state, gint *curr_state,
 		GError **error) {
-	char *cdev_str;
-
 	thd_log_debug("thd_dbus_interface_get_cdev_information %d\n", index);
 
-	cthd_cdev *cdev = thd_engine->user_get_cdev(index);
-	if (!cdev) {
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
+
+	const cthd_snapshot_layout &layout = *snap->layout;
+	if (index < 0 || index >= (gint) layout.cdevs.size()) {
 		thd_log_debug("cthd_dbus_interface_get_cdev_information: Invalid cdev index %d\n", index);
 		return FALSE;
 	}
-	cdev_str = g_new(char, MAX_DBUS_REPLY_STR_LEN + 1);
-	if (!cdev_str)
+
+	const thd_snapshot_cdev_t &cdev = layout.cdevs[index];
+	*cdev_out = thd_dbus_reply_str(cdev.type);
+	*min_state = cdev.min_state;
+	*max_state = cdev.max_state;
+	*curr_state = snap->cdev_states[index];
+
+	return TRUE;
+}
+
+gboolean thd_dbus_interface_get_engine_stats(PrefObject *obj,
+		gchar **stats_out, GError **error) {
+	std::string stats;
+
+	thd_log_debug("thd_dbus_interface_get_engine_stats\n");
+	if (!thd_engine)
 		return FALSE;
 
-	strncpy(cdev_str, cdev->get_cdev_type().c_str(),
-	MAX_DBUS_REPLY_STR_LEN);
-	cdev_str[MAX_DBUS_REPLY_STR_LEN] = '\0';
-	*cdev_out = cdev_str;
-	*min_state = cdev->get_min_state();
-	*max_state = cdev->get_max_state();
-	*curr_state = cdev->get_curr_state();
+	thd_engine->thd_engine_dump_stats(stats);
+	*stats_out = g_strdup(stats.c_str());
+
+	return TRUE;
+}
+
+// All sensors, zones with their trips and cdevs from the snapshot of the last
+// engine tick, so no sysfs access and no engine lock here
+gboolean thd_dbus_interface_get_thermal_snapshot(PrefObject *obj,
+		GVariant **snapshot_out, GError **error) {
+	GVariantBuilder sensors, zones, cdevs;
+	unsigned int trip = 0;
+
+	thd_log_debug("thd_dbus_interface_get_thermal_snapshot\n");
+
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
+	const cthd_snapshot_layout &layout = *snap->layout;
+
+	g_variant_builder_init(&sensors, G_VARIANT_TYPE("a(issux)"));
+	for (unsigned int i = 0; i < layout.sensors.size(); ++i) {
+		const thd_snapshot_sensor_t &sensor = layout.sensors[i];
+
+		g_variant_builder_add(&sensors, "(issux)", sensor.index,
+				sensor.type.c_str(), sensor.path.c_str(),
+				snap->sensor_temps[i], (gint64) snap->sensor_times[i]);
+	}
+
+	g_variant_builder_init(&zones, G_VARIANT_TYPE("a(isubasa(iiiai))"));
+	for (unsigned int i = 0; i < layout.zones.size(); ++i) {
+		const thd_snapshot_zone_t &zone = layout.zones[i];
+		GVariantBuilder zone_sensors, trips;
+
+		g_variant_builder_init(&zone_sensors, G_VARIANT_TYPE("as"));
+		for (const std::string &sensor : zone.sensors)
+			g_variant_builder_add(&zone_sensors, "s", sensor.c_str());
+
+		g_variant_builder_init(&trips, G_VARIANT_TYPE("a(iiiai)"));
+		for (const thd_snapshot_trip_t &trip_layout : zone.trips) {
+			GVariantBuilder cdev_ids;
+
+			g_variant_builder_init(&cdev_ids, G_VARIANT_TYPE("ai"));
+			for (int id : trip_layout.cdev_ids)
+				g_variant_builder_add(&cdev_ids, "i", id);
+			g_variant_builder_add(&trips, "(iiiai)", snap->trip_temps[trip++],
+					trip_layout.type, trip_layout.sensor_id, &cdev_ids);
+		}
+
+		g_variant_builder_add(&zones, "(isubasa(iiiai))", zone.index,
+				zone.type.c_str(), snap->zone_temps[i],
+				(gboolean) snap->zone_active[i], &zone_sensors, &trips);
+	}
+
+	g_variant_builder_init(&cdevs, G_VARIANT_TYPE("a(isiii)"));
+	for (unsigned int i = 0; i < layout.cdevs.size(); ++i) {
+		const thd_snapshot_cdev_t &cdev = layout.cdevs[i];
+
+		g_variant_builder_add(&cdevs, "(isiii)", cdev.index, cdev.type.c_str(),
+				cdev.min_state, cdev.max_state, snap->cdev_states[i]);
+	}
+
+	*snapshot_out = g_variant_new("(txa(issux)a(isubasa(iiiai))a(isiii))",
+			(guint64) snap->seq, (gint64) snap->time, &sensors, &zones, &cdevs);
 
 	return TRUE;
 }
@@ -508,17 +615,24 @@ gboolean thd_dbus_interface_set_zone_status(PrefObject *obj, gchar *zone_name,
 
 gboolean thd_dbus_interface_get_zone_status(PrefObject *obj, gchar *zone_name,
 		int *status, GError **error) {
-	int ret;
-
 	g_assert(obj != nullptr);
 
-	thd_log_debug("thd_dbus_interface_set_zone_status %s\n", (char*) zone_name);
+	thd_log_debug("thd_dbus_interface_get_zone_status %s\n", (char*) zone_name);
 
-	ret = thd_engine->user_get_zone_status(zone_name, status);
-	if (ret == THD_SUCCESS)
-		return TRUE;
-	else
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
 		return FALSE;
+
+	const cthd_snapshot_layout &layout = *snap->layout;
+	for (unsigned int i = 0; i < layout.zones.size(); ++i) {
+		if (layout.zones[i].type == zone_name) {
+			*status = snap->zone_active[i] ? 1 : 0;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
 }
 
 gboolean thd_dbus_interface_delete_zone(PrefObject *obj, gchar *zone_name,
@@ -576,14 +690,17 @@ gboolean thd_dbus_interface_update_cooling_device(PrefObject *obj,
 
 gboolean thd_dbus_interface_get_sensor_temperature(PrefObject *obj, int index,
 		unsigned int *temperature, GError **error) {
-	int ret;
-
-	ret = thd_engine->get_sensor_temperature(index, temperature);
+	std::shared_ptr<const cthd_engine_snapshot> snap = thd_dbus_get_snapshot(
+			error);
+	if (!snap)
+		return FALSE;
 
-	if (ret == THD_SUCCESS)
-		return TRUE;
-	else
+	if (index < 0 || index >= (int) snap->sensor_temps.size())
 		return FALSE;
+
+	*temperature = snap->sensor_temps[index];
+
+	return TRUE;
 }
 
 #ifdef GDBUS
@@ -1020,6 +1137,37 @@ thd_dbus_handle_method_call(GDBusConnection       *connection,
 		return;
 	}
 
+	if (g_strcmp0(method_name, "GetEngineStats") == 0) {
+		gboolean ret;
+		g_autofree gchar *stats = nullptr;
+
+		ret = thd_dbus_interface_get_engine_stats(obj, &stats, &error);
+
+		if (error || !ret) {
+			g_dbus_method_invocation_return_gerror(invocation, error);
+			return;
+		}
+
+		g_dbus_method_invocation_return_value(invocation,
+						      g_variant_new("(s)", stats));
+		return;
+	}
+
+	if (g_strcmp0(method_name, "GetThermalSnapshot") == 0) {
+		gboolean ret;
+		GVariant *snapshot = nullptr;
+
+		ret = thd_dbus_interface_get_thermal_snapshot(obj, &snapshot, &error);
+
+		if (error || !ret) {
+			g_dbus_method_invocation_return_gerror(invocation, error);
+			return;
+		}
+
+		g_dbus_method_invocation_return_value(invocation, snapshot);
+		return;
+	}
+
 	if (g_strcmp0(method_name, "Reinit") == 0) {
 		thd_dbus_interface_reinit(obj, &error);
 
@@ -1168,6 +1316,116 @@ thd_dbus_handle_set_property(GDBusConnection  *connection,
 }
 
 
+static GDBusConnection *signal_connection;
+// Set while an emit is scheduled on the main loop
+static std::atomic<bool> signal_pending(false);
+// g_get_monotonic_time() of the last emit
+static std::atomic<gint64> signal_last_emit(0);
+static std::shared_ptr<const cthd_engine_snapshot> signal_sent;
+// Temperatures of the last TemperatureChanged per sensor
+static std::vector<unsigned int> signal_temps;
+
+static void thd_dbus_emit_signal(const gchar *signal_name, GVariant *params)
+{
+	g_autoptr(GError) error = nullptr;
+
+	if (!g_dbus_connection_emit_signal(signal_connection, nullptr,
+					   "/org/freedesktop/thermald",
+					   "org.freedesktop.thermald",
+					   signal_name, params, &error))
+		thd_log_debug("Failed to emit %s: %s\n", signal_name,
+			      error->message);
+}
+
+// Compare the engine snapshot with the one of the last run
+static gboolean thd_dbus_emit_changes(gpointer user_data)
+{
+	// Changes published from here on schedule the next run
+	signal_last_emit.store(g_get_monotonic_time());
+	signal_pending.store(false);
+
+	if (!thd_engine)
+		return G_SOURCE_REMOVE;
+
+	std::shared_ptr<const cthd_engine_snapshot> snap =
+			thd_engine->get_snapshot();
+	if (!snap || snap == signal_sent)
+		return G_SOURCE_REMOVE;
+
+	// Objects were added or removed, start over from this snapshot
+	if (!signal_sent || signal_sent->layout != snap->layout) {
+		signal_sent = snap;
+		signal_temps = snap->sensor_temps;
+		return G_SOURCE_REMOVE;
+	}
+
+	const cthd_snapshot_layout &layout = *snap->layout;
+
+	for (unsigned int i = 0; i < layout.sensors.size(); ++i) {
+		unsigned int temp = snap->sensor_temps[i];
+		unsigned int delta = temp > signal_temps[i] ?
+				temp - signal_temps[i] : signal_temps[i] - temp;
+
+		if (!snap->sensor_times[i] || delta < signal_temp_delta)
+			continue;
+
+		signal_temps[i] = temp;
+		thd_dbus_emit_signal("TemperatureChanged",
+				     g_variant_new("(siu)",
+						   layout.sensors[i].type.c_str(),
+						   layout.sensors[i].index, temp));
+	}
+
+	unsigned int trip = 0;
+	for (unsigned int i = 0; i < layout.zones.size(); ++i) {
+		for (unsigned int j = 0; j < layout.zones[i].trips.size();
+				++j, ++trip) {
+			if (snap->trip_crossings[trip]
+					== signal_sent->trip_crossings[trip])
+				continue;
+
+			thd_dbus_emit_signal("TripCrossed",
+					     g_variant_new("(siubu)",
+							   layout.zones[i].type.c_str(), j,
+							   snap->trip_temps[trip],
+							   (gboolean) snap->trip_on[trip],
+							   snap->zone_temps[i]));
+		}
+	}
+
+	for (unsigned int i = 0; i < layout.cdevs.size(); ++i) {
+		const thd_snapshot_cdev_t &cdev = layout.cdevs[i];
+
+		if (snap->cdev_states[i] == signal_sent->cdev_states[i])
+			continue;
+
+		thd_dbus_emit_signal(cdev.power_limit ? "PowerLimitChanged" :
+						"CoolingStateChanged",
+				     g_variant_new("(sii)", cdev.type.c_str(),
+						   cdev.index, snap->cdev_states[i]));
+	}
+
+	signal_sent = snap;
+
+	return G_SOURCE_REMOVE;
+}
+
+// Engine thread: run thd_dbus_emit_changes once, signal_interval after the
+// last run
+static void thd_dbus_snapshot_changed()
+{
+	if (signal_pending.exchange(true))
+		return;
+
+	gint64 elapsed = (g_get_monotonic_time() - signal_last_emit.load())
+			/ 1000;
+	if (elapsed >= signal_interval)
+		g_idle_add(thd_dbus_emit_changes, nullptr);
+	else
+		g_timeout_add(signal_interval - elapsed, thd_dbus_emit_changes,
+			      nullptr);
+}
+
 static void
 thd_dbus_on_bus_acquired(GDBusConnection *connection,
 			 const gchar     *name,
@@ -1208,6 +1466,13 @@ thd_dbus_on_bus_acquired(GDBusConnection *connection,
 					 &error);
 	g_assert(registration_id > 0);
 	g_assert(proxy_id != nullptr);
+
+	if (signal_interval) {
+		signal_connection = connection;
+		cthd_engine::set_snapshot_notify(thd_dbus_snapshot_changed);
+		// Values to compare the first changes with
+		thd_dbus_snapshot_changed();
+	}
 }
 
 static void
@@ -35,6 +35,8 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/utsname.h>
+#include <sys/timerfd.h>
+#include <algorithm>
 #include <locale>
 #include <memory>
 #include <mutex>
@@ -47,20 +49,22 @@
 #include "thd_platform.h"
 #include "thd_platform_intel.h"
 #include "thd_platform_arm.h"
+#include "thd_simulator.h"
 #include "thd_util.h"
 
 static void *cthd_engine_thread(void *arg);
 
+std::atomic<void (*)()> cthd_engine::snapshot_notify(nullptr);
+
 cthd_engine::cthd_engine(std::string _uuid) :
 		current_cdev_index(0), current_zone_index(0), current_sensor_index(0), parse_thermal_zone_success(
 				false), parse_thermal_cdev_success(false), uuid(std::move(_uuid)), parser_disabled(
 				false), adaptive_mode(false), poll_timeout_msec(-1), wakeup_fd(
-				-1), uevent_fd(-1), control_mode(COMPLEMENTRY), write_pipe_fd(
-				0), preference(0), status(true), thz_last_uevent_time(0), thz_last_temp_ind_time(
-				0), thz_last_update_event_time(0), terminate(false), has_invariant_tsc(0),
-				has_aperf(0), proc_list_matched(false), poll_interval_sec(0), poll_sensor_mask(0),
-				fast_poll_sensor_mask(0), saved_poll_interval(0), poll_fd_cnt(0), rt_kernel(false),
-				parser_init_done(false) {
+				-1), uevent_fd(-1), timer_fd(-1), control_mode(COMPLEMENTRY), preference(0), status(true),
+				terminate(false), has_invariant_tsc(0),
+				has_aperf(0), proc_list_matched(false), poll_interval_sec(0), poll_fd_cnt(0),
+				rt_kernel(false), parser_init_done(false), sample_schedule_dirty(true), sensor_graph_dirty(true), virt_sensor_timer(-1), engine_state_timer(
+				-1), sample_tick_time(0), snapshot_layout_dirty(true), snapshot_seq(0) {
 	thd_engine = pthread_t();
 	thd_attr = pthread_attr_t();
 
@@ -74,87 +78,806 @@ cthd_engine::~cthd_engine() {
 }
 
 void cthd_engine::thd_engine_thread() {
-	unsigned int i;
 	int n;
-	time_t tm;
-	int poll_timeout_sec = poll_timeout_msec / 1000;
+	int timeout;
+	long long now;
 
 	thd_log_info("thd_engine_thread begin\n");
 	for (;;) {
 		if (terminate)
 			break;
 
-		n = poll(poll_fds, poll_fd_cnt, poll_timeout_msec);
+		thd_engine_lock();
+		now = thd_get_monotonic_msec();
+		if (sample_schedule_dirty)
+			rebuild_sample_schedule(now);
+		// Virtual sensors may have been enabled or disabled with their zone
+		timer_service.set_deadline(virt_sensor_timer,
+				sensor_graph.get_next_deadline());
+		long long wakeup = get_next_wakeup();
+		if (timer_fd >= 0) {
+			// Wakeup on the earliest zone deadline comes via timer_fd
+			arm_sample_timer(wakeup);
+			timeout = -1;
+		} else if (wakeup < 0) {
+			timeout = -1;
+		} else {
+			timeout = (wakeup > now) ? (int) (wakeup - now) : 0;
+		}
+		thd_engine_unlock();
+
+		n = poll(poll_fds, poll_fd_cnt, timeout);
 		thd_log_debug("poll exit %d polls_fd event %d %d\n", n,
 				poll_fds[0].revents, poll_fds[1].revents);
 		if (n < 0) {
 			thd_log_warn("Write to pipe failed\n");
 			continue;
 		}
-		time(&tm);
-		rapl_power_meter.rapl_measure_power();
 
-		if (n == 0 || (tm - thz_last_temp_ind_time) >= poll_timeout_sec) {
-			if (!status) {
-				thd_log_msg("Thermal Daemon is disabled\n");
-				continue;
-			}
-			thd_engine_lock();
-			// Polling mode enabled. Trigger a temp change message
-			for (i = 0; i < zones.size(); ++i) {
-				cthd_zone *zone = zones[i].get();
-				zone->zone_temperature_notification(0, 0);
-			}
-			thd_engine_unlock();
-			thz_last_temp_ind_time = tm;
+		cthd_stat_timer tick_timer(stats, STAT_TICK);
+		if (timer_fd >= 0 && (poll_fds[timer_fd].revents & POLLIN)) {
+			uint64_t expirations;
+
+			if (read(poll_fds[timer_fd].fd, &expirations, sizeof(expirations))
+					< 0)
+				thd_log_debug("read on timer fd failed\n");
 		}
+
+		uevent_ids.clear();
 		if (uevent_fd >= 0 && (poll_fds[uevent_fd].revents & POLLIN)) {
-			// Kobj uevent
-			if (kobj_uevent.check_for_event()) {
-				time_t tm;
-
-				time(&tm);
-				thd_log_debug("kobj uevent for thermal\n");
-				if ((tm - thz_last_uevent_time)
-						>= thz_notify_debounce_interval) {
-					thd_engine_lock();
-					for (i = 0; i < zones.size(); ++i) {
-						cthd_zone *zone = zones[i].get();
-						zone->zone_temperature_notification(0, 0);
-					}
-					thd_engine_unlock();
-				} else {
-					thd_log_debug("IGNORE THZ kevent\n");
-				}
-				thz_last_uevent_time = tm;
-			}
+			// Kobj uevents, drained in batches
+			if (kobj_uevent.read_events(uevent_ids))
+				thd_log_debug("kobj uevent for thermal %zu\n",
+						uevent_ids.size());
 		}
-		if (wakeup_fd >= 0 && (poll_fds[wakeup_fd].revents & POLLIN)) {
-			message_capsul_t msg;
 
+		process_tick(thd_get_monotonic_msec());
+		if (wakeup_fd >= 0 && (poll_fds[wakeup_fd].revents & POLLIN)) {
 			thd_log_debug("wakeup fd event\n");
-			int result = read(poll_fds[wakeup_fd].fd, &msg,
-					sizeof(message_capsul_t));
-			if (result < 0) {
-				thd_log_warn("read on wakeup fd failed\n");
-				poll_fds[wakeup_fd].revents = 0;
+			process_messages();
+		}
+
+		workarounds();
+	}
+	thd_log_debug("thd_engine_thread_end\n");
+}
+
+// Arm timer_fd for an absolute monotonic deadline in msec, -1 disarms it
+int cthd_engine::arm_sample_timer(long long deadline) {
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	if (deadline >= 0) {
+		its.it_value.tv_sec = deadline / 1000;
+		its.it_value.tv_nsec = (deadline % 1000) * 1000000;
+		// All zero value disarms, so make sure an expired deadline fires
+		if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+			its.it_value.tv_nsec = 1;
+	}
+
+	if (timerfd_settime(poll_fds[timer_fd].fd, TFD_TIMER_ABSTIME, &its,
+			nullptr) < 0) {
+		thd_log_warn("timerfd_settime failed: %s\n", strerror(errno));
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
+cthd_sensor *cthd_engine::search_sensor_index(int index) {
+	for (unsigned int i = 0; i < sensors.size(); ++i) {
+		if (sensors[i]->get_index() == index)
+			return sensors[i].get();
+	}
+
+	return nullptr;
+}
+
+// Sampling period in msec for a sensor, -1 if it doesn't need polling
+int cthd_engine::get_sensor_sample_period(cthd_sensor *sensor) {
+	int period = poll_timeout_msec;
+
+	if (sensor->check_fast_poll_mode())
+		return fast_poll_interval;
+
+	if (sensor->check_poll_mode()
+			&& (period < 0 || period > def_poll_interval))
+		period = def_poll_interval;
+
+	return period;
+}
+
+// A zone is sampled at the fastest period of its sensors
+int cthd_engine::get_zone_sample_period(cthd_zone *zone) {
+	int period = -1;
+
+	for (int i = 0; i < zone->get_sensor_count(); ++i) {
+		cthd_sensor *sensor = zone->get_sensor_at_index(i);
+		int sensor_period;
+
+		if (!sensor)
+			continue;
+
+		sensor_period = get_sensor_sample_period(sensor);
+		if (sensor_period > 0 && (period < 0 || sensor_period < period))
+			period = sensor_period;
+	}
+
+	return period;
+}
+
+// Return N from a sensor path containing thermal_zoneN, else -1
+static int sensor_thermal_zone_id(cthd_sensor *sensor) {
+	const std::string &path = sensor->get_sensor_path();
+	size_t pos = path.find("thermal_zone");
+
+	if (pos == std::string::npos)
+		return -1;
+
+	const char *str = path.c_str() + pos + strlen("thermal_zone");
+	char *end;
+	long id = strtol(str, &end, 10);
+	if (end == str || id < 0)
+		return -1;
+
+	return (int) id;
+}
+
+// Called with engine lock held
+void cthd_engine::rebuild_sample_schedule(long long now) {
+	sample_scheduler.clear();
+	uevent_zone_map.clear();
+	sensor_zone_map.clear();
+	sample_schedule_dirty = false;
+
+	if (sensor_graph_dirty) {
+		sensor_graph.build(sensors);
+		sensor_graph_dirty = false;
+	}
+	update_trace_names();
+
+	for (unsigned int i = 0; i < zones.size(); ++i) {
+		cthd_zone *zone = zones[i].get();
+		int period = get_zone_sample_period(zone);
+
+		for (int j = 0; j < zone->get_sensor_count(); ++j) {
+			cthd_sensor *sensor = zone->get_sensor_at_index(j);
+			if (!sensor)
 				continue;
+			// Replay feeds sensors directly, no batch reads from sysfs
+			if (!thd_replay_file && sensor->get_snapshot_slot() < 0)
+				sensor->register_snapshot(&sensor_snapshot);
+			sensor_zone_map[sensor->get_index()].push_back(zone);
+
+			int id = sensor_thermal_zone_id(sensor);
+			if (id >= 0)
+				uevent_zone_map[id].push_back(zone);
+		}
+
+		if (period < 0) {
+			zone->set_next_sample_time(0);
+			continue;
+		}
+
+		// Keep the existing phase unless the period got shorter
+		long long next = zone->get_next_sample_time();
+		if (!next || next > now + period)
+			next = now + period;
+
+		zone->set_next_sample_time(next);
+		sample_scheduler.schedule(zone, next);
+	}
+}
+
+// Called with engine lock held
+void cthd_engine::update_trace_names() {
+	trace.clear_names();
+	for (unsigned int i = 0; i < sensors.size(); ++i)
+		trace.add_name(TRACE_NAME_SENSOR, sensors[i]->get_index(),
+				sensors[i]->get_sensor_type());
+	for (unsigned int i = 0; i < zones.size(); ++i)
+		trace.add_name(TRACE_NAME_ZONE, zones[i]->get_zone_index(),
+				zones[i]->get_zone_type());
+	for (unsigned int i = 0; i < cdevs.size(); ++i)
+		trace.add_name(TRACE_NAME_CDEV, cdevs[i]->thd_cdev_get_index(),
+				cdevs[i]->get_cdev_type());
+}
+
+// Called with engine lock held
+void cthd_engine::process_sample_schedule(long long now) {
+	cthd_zone *zone;
+
+	due_zones.clear();
+	while ((zone = sample_scheduler.pop_due(now)) != nullptr) {
+		add_due_zone(zone);
+
+		int period = get_zone_sample_period(zone);
+		if (period < 0) {
+			zone->set_next_sample_time(0);
+			continue;
+		}
+
+		long long next = zone->get_next_sample_time() + period;
+		if (next <= now)
+			next = now + period;
+
+		zone->set_next_sample_time(next);
+		sample_scheduler.schedule(zone, next);
+	}
+
+	process_uevents(now);
+
+	if (due_zones.empty())
+		return;
+
+	if (!status) {
+		thd_log_msg("Thermal Daemon is disabled\n");
+		return;
+	}
+
+	sample_due_zones();
+}
+
+void cthd_engine::add_due_zone(cthd_zone *zone) {
+	if (std::find(due_zones.begin(), due_zones.end(), zone) == due_zones.end())
+		due_zones.push_back(zone);
+}
+
+// Attribute received uevents to zones and debounce them per zone. A zone
+// which got an event within its debounce interval is evaluated once, when
+// the interval expires. Called with engine lock held.
+void cthd_engine::process_uevents(long long now) {
+	for (int id : uevent_ids) {
+		if (id < 0) {
+			// No thermal zone number in DEVPATH, can't attribute
+			for (unsigned int i = 0; i < zones.size(); ++i) {
+				cthd_zone *zone = zones[i].get();
+				if (!zone->get_uevent_pending_time())
+					zone->set_uevent_pending_time(now);
 			}
-			if (proc_message(&msg) < 0) {
-				thd_log_debug("Terminating thread..\n");
+			continue;
+		}
+
+		auto it = uevent_zone_map.find(id);
+		if (it == uevent_zone_map.end()) {
+			thd_log_debug("uevent for thermal_zone%d, no zone uses it\n", id);
+			continue;
+		}
+
+		for (cthd_zone *zone : it->second) {
+			int debounce = zone->get_uevent_debounce_interval();
+			if (debounce < 0)
+				debounce = thz_notify_debounce_interval;
+
+			long long due = zone->get_last_uevent_time() + debounce;
+			if (due < now)
+				due = now;
+
+			long long pending = zone->get_uevent_pending_time();
+			if (!pending || due < pending)
+				zone->set_uevent_pending_time(due);
+		}
+	}
+
+	for (unsigned int i = 0; i < zones.size(); ++i) {
+		cthd_zone *zone = zones[i].get();
+		long long pending = zone->get_uevent_pending_time();
+
+		if (!pending || pending > now)
+			continue;
+
+		zone->set_uevent_pending_time(0);
+		zone->set_last_uevent_time(now);
+		zone->mark_dirty();
+		add_due_zone(zone);
+	}
+}
+
+// Periodic work besides zone sampling, run from the engine loop
+void cthd_engine::register_timers() {
+	timer_service.set_wakeup([this]() {
+		send_message(WAKEUP, 0, nullptr);
+	});
+
+	virt_sensor_timer = timer_service.add_timer(-1, 0,
+			[this](long long, long long now) {
+				thd_engine_lock();
+				sensor_graph.process(now);
+				long long next = sensor_graph.get_next_deadline();
+				thd_engine_unlock();
+				return next;
+			});
+
+	int interval = thd_poll_interval > 0 ? thd_poll_interval * 1000 :
+											def_poll_interval;
+	engine_state_timer = timer_service.add_timer(0, engine_state_timer_slack,
+			[this, interval](long long deadline, long long now) {
+				cthd_stat_timer timer(stats, STAT_ENGINE_STATE);
+				thd_engine_lock();
+				update_engine_state();
+				thd_engine_unlock();
+				return cthd_timer_service::next_period(deadline, now, interval);
+			});
+
+	// Snapshot readers also see sensors which no zone samples
+	timer_service.add_timer(0, engine_state_timer_slack,
+			[this, interval](long long deadline, long long now) {
+				thd_engine_lock();
+				refresh_idle_sensors(now - interval);
+				publish_snapshot(now);
+				thd_engine_unlock();
+				return cthd_timer_service::next_period(deadline, now, interval);
+			});
+
+	if (thd_metrics_interval > 0)
+		timer_service.add_timer(0, engine_state_timer_slack,
+				[this](long long deadline, long long now) {
+					write_metrics();
+					return cthd_timer_service::next_period(deadline, now,
+							thd_metrics_interval * 1000LL);
+				});
+
+	rapl_power_meter.rapl_enable_periodic_timer(timer_service);
+}
+
+// Copy the counters under the engine lock, format and write without it
+void cthd_engine::write_metrics() {
+	thd_metrics_sample_t sample;
+
+	thd_engine_lock();
+	sample.snap = get_snapshot();
+	if (sample.snap && sample.snap->layout->sensors.size() == sensors.size()) {
+		for (unsigned int i = 0; i < sensors.size(); ++i)
+			sample.sensor_read_errors.push_back(
+					sensors[i]->get_sysfs_read_errors());
+	}
+	if (sample.snap && sample.snap->layout->cdevs.size() == cdevs.size()) {
+		for (unsigned int i = 0; i < cdevs.size(); ++i)
+			sample.cdev_write_errors.push_back(
+					cdevs[i]->get_sysfs_write_errors());
+	}
+	sample.state_time = metrics.get_state_time();
+	thd_engine_unlock();
+
+	if (sample.snap)
+		metrics.write(thd_metrics_file ? thd_metrics_file :
+				csys_fs::map_path(TDRUNDIR "/thermald.prom"), sample, stats,
+				rapl_power_meter);
+}
+
+void cthd_engine::thd_engine_dump_stats(std::string &out) {
+	std::ostringstream str;
+	long long max, avg;
+	unsigned long count;
+
+	stats.dump(str);
+
+	timer_service.get_latency(&max, &avg, &count);
+	str << "timer_latency count " << count << " avg_ms " << avg << " max_ms "
+			<< max << "\n";
+
+	std::lock_guard<std::mutex> guard(thd_engine_mutex);
+	for (unsigned int i = 0; i < sensors.size(); ++i) {
+		cthd_sensor *sensor = sensors[i].get();
+
+		str << "sensor " << sensor->get_sensor_type() << " reads "
+				<< sensor->get_sysfs_reads() << " errors "
+				<< sensor->get_sysfs_read_errors() << "\n";
+	}
+	for (unsigned int i = 0; i < cdevs.size(); ++i) {
+		cthd_cdev *cdev = cdevs[i].get();
+
+		str << "cdev " << cdev->get_cdev_type() << " writes "
+				<< cdev->get_sysfs_writes() << " errors "
+				<< cdev->get_sysfs_write_errors() << "\n";
+	}
+
+	out = str.str();
+}
+
+void cthd_engine::build_snapshot_layout(unsigned int trip_count) {
+	std::unique_ptr<cthd_snapshot_layout> layout(new cthd_snapshot_layout());
+	unsigned int first_trip = 0;
+
+	layout->sensors.reserve(sensors.size());
+	for (unsigned int i = 0; i < sensors.size(); ++i) {
+		cthd_sensor *sensor = sensors[i].get();
+
+		layout->sensors.push_back( { sensor->get_index(),
+				sensor->get_sensor_type(), sensor->get_sensor_path() });
+	}
+
+	layout->zones.resize(zones.size());
+	for (unsigned int i = 0; i < zones.size(); ++i) {
+		cthd_zone *zone = zones[i].get();
+		thd_snapshot_zone_t &zone_layout = layout->zones[i];
+
+		zone_layout.index = zone->get_zone_index();
+		zone_layout.type = zone->get_zone_type();
+		for (int j = 0; j < zone->get_sensor_count(); ++j)
+			zone_layout.sensors.push_back(
+					zone->get_sensor_at_index(j)->get_sensor_type());
+
+		zone_layout.first_trip = first_trip;
+		first_trip += zone->get_trip_count();
+		zone_layout.trips.resize(zone->get_trip_count());
+		for (unsigned int j = 0; j < zone->get_trip_count(); ++j) {
+			cthd_trip_point *trip = zone->get_trip_at_index(j);
+			thd_snapshot_trip_t &trip_layout = zone_layout.trips[j];
+
+			trip_layout.type = trip->get_trip_type();
+			trip_layout.sensor_id = trip->get_sensor_id();
+			for (unsigned int k = 0; k < trip->get_cdev_count(); ++k)
+				trip_layout.cdev_ids.push_back(
+						trip->get_cdev_at_index(k).cdev->thd_cdev_get_index());
+		}
+	}
+
+	layout->cdevs.reserve(cdevs.size());
+	for (unsigned int i = 0; i < cdevs.size(); ++i) {
+		cthd_cdev *cdev = cdevs[i].get();
+
+		layout->cdevs.push_back( { cdev->thd_cdev_get_index(),
+				cdev->get_cdev_type(), cdev->get_min_state(),
+				cdev->get_max_state(), cdev->is_power_limit() });
+	}
+
+	layout->trip_count = trip_count;
+	snapshot_layout = std::move(layout);
+	snapshot_layout_dirty = false;
+}
+
+// Called with engine lock held. Read the sensors not sampled since
+// older_than, a zone sampling them already keeps them fresh.
+void cthd_engine::refresh_idle_sensors(long long older_than) {
+	for (unsigned int i = 0; i < sensors.size(); ++i) {
+		long long time;
+
+		sensors[i]->get_last_temp(&time);
+		if (time <= older_than)
+			sensors[i]->read_temperature();
+	}
+}
+
+// Called with the engine lock held. A pool snapshot no reader holds, so a
+// tick doesn't allocate once the value vectors have their size.
+std::shared_ptr<cthd_engine_snapshot> cthd_engine::get_free_snapshot() {
+	for (int i = 0; i < snapshot_pool_size; ++i) {
+		if (snapshot_pool[i] && snapshot_pool[i].use_count() == 1) {
+			// Pairs with the release of the last reader's reference
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return snapshot_pool[i];
+		}
+	}
+
+	// All held, readers keep the replaced one alive
+	std::shared_ptr<cthd_engine_snapshot> &slot = snapshot_pool[snapshot_seq
+			% snapshot_pool_size];
+	slot = std::make_shared<cthd_engine_snapshot>();
+
+	return slot;
+}
+
+// Called with the engine lock held. Only the values are copied per tick,
+// names come from the shared layout.
+void cthd_engine::publish_snapshot(long long now) {
+	unsigned int trip_count = 0;
+
+	for (unsigned int i = 0; i < zones.size(); ++i)
+		trip_count += zones[i]->get_trip_count();
+
+	if (snapshot_layout_dirty || !snapshot_layout
+			|| snapshot_layout->sensors.size() != sensors.size()
+			|| snapshot_layout->zones.size() != zones.size()
+			|| snapshot_layout->cdevs.size() != cdevs.size()
+			|| snapshot_layout->trip_count != trip_count)
+		build_snapshot_layout(trip_count);
+
+	std::shared_ptr<cthd_engine_snapshot> snap = get_free_snapshot();
+
+	snap->seq = ++snapshot_seq;
+	snap->time = now;
+	snap->layout = snapshot_layout;
+
+	snap->sensor_temps.resize(sensors.size());
+	snap->sensor_times.resize(sensors.size());
+	for (unsigned int i = 0; i < sensors.size(); ++i)
+		snap->sensor_temps[i] = sensors[i]->get_last_temp(
+				&snap->sensor_times[i]);
+
+	snap->zone_temps.resize(zones.size());
+	snap->zone_active.resize(zones.size());
+	snap->trip_temps.resize(trip_count);
+	snap->trip_on.resize(trip_count);
+	snap->trip_crossings.resize(trip_count);
+	unsigned int trip_index = 0;
+	for (unsigned int i = 0; i < zones.size(); ++i) {
+		cthd_zone *zone = zones[i].get();
+
+		snap->zone_temps[i] = zone->get_zone_temp();
+		snap->zone_active[i] = zone->zone_active_status();
+		for (unsigned int j = 0; j < zone->get_trip_count(); ++j) {
+			cthd_trip_point *trip = zone->get_trip_at_index(j);
+
+			snap->trip_temps[trip_index] = trip->get_trip_temp();
+			snap->trip_on[trip_index] = trip->is_trip_on();
+			snap->trip_crossings[trip_index] = trip->get_crossings();
+			++trip_index;
+		}
+	}
+
+	snap->cdev_states.resize(cdevs.size());
+	for (unsigned int i = 0; i < cdevs.size(); ++i)
+		snap->cdev_states[i] = cdevs[i]->get_curr_state();
+
+	telemetry.publish(*snap, rapl_power_meter);
+	if (thd_metrics_interval > 0)
+		metrics.record(*snap);
+
+	// Only written under the engine lock, so no snapshot_mutex to read it
+	bool changed = !snapshot || snapshot->layout != snap->layout
+			|| snapshot->sensor_temps != snap->sensor_temps
+			|| snapshot->trip_crossings != snap->trip_crossings
+			|| snapshot->cdev_states != snap->cdev_states;
+
+	{
+		std::lock_guard<std::mutex> guard(snapshot_mutex);
+		snapshot = snap;
+	}
+
+	void (*notify)() = snapshot_notify.load(std::memory_order_relaxed);
+	if (changed && notify)
+		notify();
+}
+
+void cthd_engine::thd_engine_log_stats() {
+	std::string out;
+
+	thd_engine_dump_stats(out);
+
+	std::istringstream lines(out);
+	std::string line;
+	while (std::getline(lines, line))
+		thd_log_msg("stats: %s\n", line.c_str());
+}
+
+void cthd_engine::cdev_state_changed(cthd_cdev *cdev, int zone_id, int state) {
+	trace.record(TRACE_CDEV_STATE, cdev->thd_cdev_get_index(), zone_id, state);
+
+	// Captured instead of applied, see thd_engine_replay()
+	if (thd_replay_file)
+		printf("%lld,%s,%d,%d\n", thd_get_monotonic_nsec(),
+				cdev->get_cdev_type().c_str(), zone_id, state);
+}
+
+/* Drive the engine with sensor samples from a trace recorded by cthd_trace,
+ * as fast as possible. The monotonic clock follows the recorded time, so
+ * debounce and sampling intervals behave as in the recorded run. Samples
+ * recorded within one msec form one tick: the sensors get their recorded
+ * values and the zones using them are evaluated. Other inputs, like the
+ * adaptive engine conditions, still come from the running system. Sysfs
+ * writes are dropped (csys_fs dry run) and cooling device state changes are
+ * printed as CSV.
+ * The trace is repeated with shifted time to measure the CPU cost of a
+ * tick over many iterations.
+ */
+int cthd_engine::thd_engine_replay(const std::string &path, int repeat) {
+	static constexpr long long tick_window_ns = 1000000;
+	cthd_trace_reader reader;
+	std::unordered_map<int, cthd_sensor *> sensor_map;
+	cthd_latency_histogram tick_cost;
+	unsigned long samples = 0;
+	struct timespec begin, end;
+
+	if (reader.load(path) != THD_SUCCESS)
+		return THD_ERROR;
+
+	const std::vector<cthd_trace_reader::trace_entry_t> &entries =
+			reader.get_entries();
+	if (entries.empty()) {
+		thd_log_error("No records in trace %s\n", path.c_str());
+		return THD_ERROR;
+	}
+
+	// Sensor indexes differ between systems, match by name
+	for (const auto &entry : entries) {
+		if (entry.type != TRACE_SAMPLE || sensor_map.count(entry.id))
+			continue;
+
+		std::string name = reader.get_name(TRACE_NAME_SENSOR, entry.id);
+		cthd_sensor *sensor = search_sensor(name);
+		if (!sensor)
+			thd_log_warn("replay: no sensor %s, its samples are ignored\n",
+					name.c_str());
+		sensor_map[entry.id] = sensor;
+	}
+
+	long long first = entries.front().time_ns;
+	long long span = entries.back().time_ns - first + tick_window_ns;
+	int state_interval = thd_poll_interval > 0 ? thd_poll_interval * 1000 :
+													def_poll_interval;
+	long long next_state_update = 0;
+
+	thd_set_virtual_time(first);
+	rebuild_sample_schedule(first / 1000000);
+
+	printf("time_ns,cdev,zone,state\n");
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int r = 0; r < repeat; ++r) {
+		unsigned int i = 0;
+
+		while (i < entries.size()) {
+			long long tick_ns = entries[i].time_ns;
+			long long now_ns = tick_ns + r * span;
+			struct timespec cpu_start, cpu_end;
+
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+			thd_set_virtual_time(now_ns);
+			sample_tick_time.store(now_ns / 1000000, std::memory_order_release);
+
+			// As engine_state_timer, for the adaptive engine conditions
+			if (now_ns / 1000000 >= next_state_update) {
+				update_engine_state();
+				next_state_update = now_ns / 1000000 + state_interval;
+			}
+
+			due_zones.clear();
+			for (; i < entries.size()
+					&& entries[i].time_ns < tick_ns + tick_window_ns; ++i) {
+				if (entries[i].type != TRACE_SAMPLE)
+					continue;
+
+				cthd_sensor *sensor = sensor_map[entries[i].id];
+				if (!sensor)
+					continue;
+
+				sensor->set_replay_temp(entries[i].value);
+				++samples;
+
+				auto it = sensor_zone_map.find(sensor->get_index());
+				if (it == sensor_zone_map.end())
+					continue;
+				for (cthd_zone *zone : it->second)
+					add_due_zone(zone);
 			}
+
+			if (!due_zones.empty())
+				sample_due_zones();
+
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+			tick_cost.record(
+					(cpu_end.tv_sec - cpu_start.tv_sec) * 1000000000LL
+							+ cpu_end.tv_nsec - cpu_start.tv_nsec);
 		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	thd_set_virtual_time(-1);
+
+	double elapsed = (end.tv_sec - begin.tv_sec)
+			+ (end.tv_nsec - begin.tv_nsec) / 1e9;
+	fflush(stdout);
+	fprintf(stderr,
+			"replay: %lu ticks %lu samples in %.3f s, tick cpu ns avg %lld p50 %lld p99 %lld max %lld\n",
+			tick_cost.get_count(), samples, elapsed, tick_cost.get_avg(),
+			tick_cost.percentile(50), tick_cost.percentile(99),
+			tick_cost.get_max());
+
+	return THD_SUCCESS;
+}
 
-		if ((tm - thz_last_update_event_time) >= thd_poll_interval) {
-			thd_engine_lock();
-			update_engine_state();
-			thd_engine_unlock();
-			thz_last_update_event_time = tm;
+/* Run the controllers closed loop against a simulated platform, see
+ * cthd_simulator. The engine has only the simulated sensors, cooling
+ * devices and zones, which are sampled at the scenario sampling period in
+ * virtual time. The metrics are printed to stdout at the end.
+ */
+int cthd_engine::thd_engine_simulate(cthd_simulator &sim) {
+	// Start away from 0, which means unset for action and sample times
+	static constexpr long long start_ns = 1000000000000LL;
+	struct timespec begin, end;
+
+	sim.attach(sensors, cdevs, zones);
+	poll_timeout_msec = sim.get_sample_period();
+	preference = PREF_ENERGY_CONSERVE;
+
+	thd_set_virtual_time(start_ns);
+	rebuild_sample_schedule(start_ns / 1000000);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	while (sim.get_elapsed() < sim.get_duration()) {
+		long long now_ns = start_ns + sim.get_elapsed() * 1000000;
+
+		thd_set_virtual_time(now_ns);
+		sample_tick_time.store(now_ns / 1000000, std::memory_order_release);
+		sim.update_sensors();
+		process_sample_schedule(now_ns / 1000000);
+		sim.step();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	thd_set_virtual_time(-1);
+
+	sim.report(stdout);
+	fflush(stdout);
+	fprintf(stderr, "simulate: %.1f s simulated in %.3f s\n",
+			sim.get_elapsed() / 1000.0,
+			(end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9);
+
+	return THD_SUCCESS;
+}
+
+// RAPL counters, timers and zone sampling of one loop iteration
+void cthd_engine::process_tick(long long now) {
+	{
+		cthd_stat_timer timer(stats, STAT_RAPL);
+		rapl_power_meter.rapl_measure_power();
+	}
+
+	// Sensors read once in this tick, even when shared by zones
+	sample_tick_time.store(now, std::memory_order_release);
+	{
+		cthd_stat_timer timer(stats, STAT_TIMERS);
+		timer_service.run(now);
+	}
+
+	// Sample only the zones whose deadline expired or got a uevent
+	thd_engine_lock();
+	if (sample_schedule_dirty)
+		rebuild_sample_schedule(now);
+	process_sample_schedule(now);
+	publish_snapshot(now);
+	thd_engine_unlock();
+}
+
+// Drain everything queued, not one message per wakeup
+void cthd_engine::process_messages() {
+	cthd_stat_timer timer(stats, STAT_MESSAGES);
+	message_capsul_t msg;
+
+	msg_queue.clear_doorbell();
+	while (msg_queue.pop(&msg)) {
+		if (proc_message(&msg) < 0) {
+			thd_log_debug("Terminating thread..\n");
 		}
+	}
+}
 
-		workarounds();
+// Earliest of sampling deadlines, timers and pending uevents, -1 when none
+long long cthd_engine::get_next_wakeup() {
+	long long wakeup = sample_scheduler.get_next_deadline();
+	long long timer_deadline = timer_service.get_next_deadline();
+
+	if (timer_deadline >= 0 && (wakeup < 0 || timer_deadline < wakeup))
+		wakeup = timer_deadline;
+
+	for (unsigned int i = 0; i < zones.size(); ++i) {
+		long long pending = zones[i]->get_uevent_pending_time();
+
+		if (pending && (wakeup < 0 || pending < wakeup))
+			wakeup = pending;
 	}
-	thd_log_debug("thd_engine_thread_end\n");
+
+	return wakeup;
+}
+
+// Read sensors of all zones in due_zones in one batch, then let each zone
+// process its temperature from the snapshot. Called with engine lock held.
+void cthd_engine::sample_due_zones() {
+	cthd_stat_timer timer(stats, STAT_ZONES);
+
+	snapshot_slots.clear();
+	for (cthd_zone *zone : due_zones) {
+		for (int i = 0; i < zone->get_sensor_count(); ++i) {
+			cthd_sensor *sensor = zone->get_sensor_at_index(i);
+			if (sensor && sensor->get_snapshot_slot() >= 0)
+				snapshot_slots.push_back(sensor->get_snapshot_slot());
+		}
+	}
+	sensor_snapshot.refresh(snapshot_slots);
+
+	for (cthd_zone *zone : due_zones)
+		zone->zone_temperature_notification(0, 0);
+
+	// Reads outside of a sampling tick go to sysfs again
+	sensor_snapshot.invalidate();
 }
 
 bool cthd_engine::set_preference(const int pref) {
@@ -295,6 +1018,8 @@ int cthd_engine::thd_engine_init(bool ignore_cpuid_check, bool adaptive) {
 		}
 	}
 
+	cthd_stat_timer discovery_timer(stats, STAT_DISCOVERY);
+
 	ret = read_thermal_sensors();
 	if (ret != THD_SUCCESS) {
 		thd_log_error("Thermal sysfs Error in reading sensors\n");
@@ -316,6 +1041,14 @@ int cthd_engine::thd_engine_init(bool ignore_cpuid_check, bool adaptive) {
 		return THD_FATAL_ERROR;
 	}
 
+	// Virtual sensors of the config linked in a cycle can't be read
+	ret = sensor_graph.build(sensors);
+	if (ret != THD_SUCCESS) {
+		thd_log_error("Virtual sensor link cycle in the configuration\n");
+		return THD_FATAL_ERROR;
+	}
+	sensor_graph_dirty = false;
+
 	if (power_floor_enable)
 		enable_power_floor_event();
 
@@ -324,34 +1057,37 @@ int cthd_engine::thd_engine_init(bool ignore_cpuid_check, bool adaptive) {
 
 int cthd_engine::thd_engine_start() {
 	int ret;
-	int wake_fds[2];
+
+	if (thd_replay_file)
+		return thd_engine_replay(thd_replay_file, thd_replay_repeat);
 
 	check_for_rt_kernel();
 
-	// Pipe is used for communication between two processes
-	ret = pipe(wake_fds);
-	if (ret) {
-		thd_log_error("Thermal sysfs: pipe creation failed %d:\n", ret);
-		return THD_FATAL_ERROR;
-	}
-	if (fcntl(wake_fds[0], F_SETFL, O_NONBLOCK) < 0) {
-		thd_log_error("Cannot set non-blocking on pipe: %s\n", strerror(errno));
-		return THD_FATAL_ERROR;
-	}
-	if (fcntl(wake_fds[1], F_SETFL, O_NONBLOCK) < 0) {
-		thd_log_error("Cannot set non-blocking on pipe: %s\n", strerror(errno));
+	// Messages to the engine thread are queued, eventfd wakes up the poll
+	if (msg_queue.open() != THD_SUCCESS)
 		return THD_FATAL_ERROR;
-	}
-	write_pipe_fd = wake_fds[1];
 
 	memset(poll_fds, 0, sizeof(poll_fds));
 
 	wakeup_fd = poll_fd_cnt;
-	poll_fds[wakeup_fd].fd = wake_fds[0];
+	poll_fds[wakeup_fd].fd = msg_queue.get_fd();
 	poll_fds[wakeup_fd].events = POLLIN;
 	poll_fds[wakeup_fd].revents = 0;
 	poll_fd_cnt++;
 
+	timer_fd = poll_fd_cnt;
+	poll_fds[timer_fd].fd = timerfd_create(CLOCK_MONOTONIC,
+			TFD_NONBLOCK | TFD_CLOEXEC);
+	if (poll_fds[timer_fd].fd < 0) {
+		thd_log_warn("timerfd_create failed, use poll timeout: %s\n",
+				strerror(errno));
+		timer_fd = -1;
+	} else {
+		poll_fds[timer_fd].events = POLLIN;
+		poll_fds[timer_fd].revents = 0;
+		poll_fd_cnt++;
+	}
+
 	poll_timeout_msec = -1;
 	if (poll_interval_sec) {
 		thd_log_msg("Polling mode is enabled: %d\n", poll_interval_sec);
@@ -407,35 +1143,19 @@ int cthd_engine::thd_engine_start() {
 		poll_fd_cnt++;
 	}
 	skip_kobj:
-#ifndef DISABLE_PTHREAD
+	trace.open(csys_fs::map_path(TDRUNDIR "/thermald.trace"));
+	if (thd_telemetry_enable)
+		telemetry.open(csys_fs::map_path(TDRUNDIR "/thermald.telemetry"));
+	// Telemetry and metrics report RAPL power even without a RAPL cdev
+	if (telemetry.is_open() || thd_metrics_interval > 0)
+		rapl_power_meter.rapl_start_measure_power();
+	register_timers();
+
 	// Create thread
 	pthread_attr_init(&thd_attr);
 	pthread_attr_setdetachstate(&thd_attr, PTHREAD_CREATE_DETACHED);
 	ret = pthread_create(&thd_engine, &thd_attr, cthd_engine_thread,
 			(void*) this);
-#else
-	{
-		pid_t childpid;
-
-		if((childpid = fork()) == - 1)
-		{
-			perror("fork");
-			exit(EXIT_FAILURE);
-		}
-
-		if(childpid == 0)
-		{
-			/* Child process closes up input side of pipe */
-			close(wake_fds[1]);
-			cthd_engine_thread((void*)this);
-		}
-		else
-		{
-			/* Parent process closes up output side of pipe */
-			close(wake_fds[0]);
-		}
-	}
-#endif
 	thd_pref.refresh();
 	preference = thd_pref.get_preference();
 	thd_log_info("Current user preference is %d\n", preference);
@@ -467,12 +1187,12 @@ void cthd_engine::send_message(message_name_t msg_id, int size,
 	memset(&msg_cap, 0, sizeof(message_capsul_t));
 
 	msg_cap.msg_id = msg_id;
-	msg_cap.msg_size = (size > MAX_MSG_SIZE) ? MAX_MSG_SIZE : size;
+	msg_cap.msg_size = (size > (int) sizeof(msg_cap.msg)) ?
+			(int) sizeof(msg_cap.msg) : size;
 	if (msg)
 		memcpy(msg_cap.msg, msg, msg_cap.msg_size);
-	int result = write(write_pipe_fd, &msg_cap, sizeof(message_capsul_t));
-	if (result < 0)
-		thd_log_warn("Write to pipe failed\n");
+	if (!msg_queue.push(msg_cap))
+		thd_log_warn("Engine message queue is full, drop %d\n", msg_id);
 }
 
 void cthd_engine::process_pref_change() {
@@ -553,49 +1273,73 @@ void cthd_engine::thermal_zone_change(message_capsul_t *msg) {
 	thermal_zone_notify_t *pmsg = (thermal_zone_notify_t*) msg->msg;
 	for (unsigned i = 0; i < zones.size(); ++i) {
 		cthd_zone *zone = zones[i].get();
-		if (zone->zone_active_status())
+		if (zone->zone_active_status()) {
+			zone->mark_dirty();
 			zone->zone_temperature_notification(pmsg->type, pmsg->data);
+		}
 		else {
 			thd_log_debug("zone is not active\n");
 		}
 	}
 }
 
+// Evaluate only the zones which read this sensor
+void cthd_engine::sensor_changed(message_capsul_t *msg) {
+	int *sensor_id = (int*) msg->msg;
+
+	thd_engine_lock();
+	// Zones may have been deleted or reloaded since the last tick
+	if (sample_schedule_dirty)
+		rebuild_sample_schedule(thd_get_monotonic_msec());
+	auto it = sensor_zone_map.find(*sensor_id);
+	if (it != sensor_zone_map.end()) {
+		due_zones.clear();
+		for (cthd_zone *zone : it->second) {
+			if (!zone->zone_active_status())
+				continue;
+			zone->mark_dirty();
+			add_due_zone(zone);
+		}
+		if (!due_zones.empty())
+			sample_due_zones();
+	}
+	thd_engine_unlock();
+}
+
 void cthd_engine::poll_enable_disable(bool status, message_capsul_t *msg) {
 	unsigned int *sensor_id = (unsigned int*) msg->msg;
 
-	if (status) {
-		poll_sensor_mask |= (1 << (*sensor_id));
-		poll_timeout_msec = def_poll_interval;
-		thd_log_debug("thd_engine polling enabled via %u\n", *sensor_id);
-	} else {
-		poll_sensor_mask &= ~(1 << (*sensor_id));
-		if (!poll_sensor_mask) {
-			poll_timeout_msec = -1;
-			thd_log_debug("thd_engine polling last disabled via %u\n",
-					*sensor_id);
-		}
+	thd_engine_lock();
+	cthd_sensor *sensor = search_sensor_index(*sensor_id);
+	if (sensor) {
+		sensor->set_poll_mode(status);
+		thd_engine_reschedule();
 	}
+	thd_engine_unlock();
+
+	if (status)
+		thd_log_debug("thd_engine polling enabled via %u\n", *sensor_id);
+	else
+		thd_log_debug("thd_engine polling disabled via %u\n", *sensor_id);
 }
 
+// Only zones using this sensor are sampled at fast_poll_interval
 void cthd_engine::fast_poll_enable_disable(bool status, message_capsul_t *msg) {
 	unsigned int *sensor_id = (unsigned int*) msg->msg;
 
-	if (status) {
-		fast_poll_sensor_mask |= (1 << (*sensor_id));
-		if (!saved_poll_interval)
-			saved_poll_interval = poll_timeout_msec;
-		poll_timeout_msec = 1000;
-		thd_log_debug("thd_engine fast polling enabled via %u\n", *sensor_id);
-	} else {
-		fast_poll_sensor_mask &= ~(1 << (*sensor_id));
-		if (!fast_poll_sensor_mask) {
-			if (saved_poll_interval)
-				poll_timeout_msec = saved_poll_interval;
-			thd_log_debug("thd_engine polling last disabled via %u\n",
-					*sensor_id);
-		}
+	thd_engine_lock();
+	cthd_sensor *sensor = search_sensor_index(*sensor_id);
+	if (sensor) {
+		sensor->set_fast_poll_mode(status);
+		thd_engine_reschedule();
 	}
+	thd_engine_unlock();
+
+	if (status)
+		thd_log_debug("thd_engine fast polling enabled via %u\n", *sensor_id);
+	else
+		thd_log_debug("thd_engine fast polling disabled via %u\n",
+				*sensor_id);
 }
 
 int cthd_engine::proc_message(message_capsul_t *msg) {
@@ -640,6 +1384,10 @@ int cthd_engine::proc_message(message_capsul_t *msg) {
 	case FAST_POLL_DISABLE:
 		fast_poll_enable_disable(false, msg);
 		break;
+	case SENSOR_CHANGED:
+		if (status)
+			sensor_changed(msg);
+		break;
 	default:
 		break;
 	}
@@ -667,7 +1415,7 @@ void cthd_engine::takeover_thermal_control() {
 
 	int3400.set_default_uuid();
 
-	if ((dir = opendir(base_path.c_str())) != nullptr) {
+	if ((dir = opendir(csys_fs::map_path(base_path).c_str())) != nullptr) {
 		while ((entry = readdir(dir)) != nullptr) {
 			if (!strncmp(entry->d_name, "thermal_zone",
 					strlen("thermal_zone"))) {
@@ -720,7 +1468,7 @@ void cthd_engine::giveup_thermal_control() {
 	struct dirent *entry;
 	const std::string base_path = "/sys/class/thermal/";
 	int cnt = 0;
-	if ((dir = opendir(base_path.c_str())) != nullptr) {
+	if ((dir = opendir(csys_fs::map_path(base_path).c_str())) != nullptr) {
 		while ((entry = readdir(dir)) != nullptr) {
 			if (!strncmp(entry->d_name, "thermal_zone",
 					strlen("thermal_zone"))) {
@@ -775,9 +1523,18 @@ void cthd_engine::thd_engine_fast_poll_disable(int sensor_id) {
 			(unsigned char*) &sensor_id);
 }
 
+void cthd_engine::thd_engine_sensor_changed(int sensor_id) {
+	send_message(SENSOR_CHANGED, (int) sizeof(sensor_id),
+			(unsigned char*) &sensor_id);
+}
+
 void cthd_engine::thd_engine_reload_zones() {
+	std::lock_guard<std::mutex> guard(thd_engine_mutex);
+
 	thd_log_msg(" Reloading zones\n");
 	zones.clear();
+	thd_engine_reschedule();
+	snapshot_layout_dirty = true;
 
 	int ret = read_thermal_zones();
 	if (ret != THD_SUCCESS) {
@@ -785,6 +1542,7 @@ void cthd_engine::thd_engine_reload_zones() {
 		// This is a fatal error and daemon will exit
 		return;
 	}
+	publish_snapshot(thd_get_monotonic_msec());
 }
 
 int cthd_engine::check_cpu_id() {
@@ -811,7 +1569,8 @@ void cthd_engine::thd_read_default_thermal_sensors() {
 	const std::string base_path = "/sys/class/thermal/";
 	int max_index = 0;
 
-	if ((dir = opendir("/sys/class/thermal/thermal_zone1/")) == nullptr) {
+	if ((dir = opendir(csys_fs::map_path(
+			"/sys/class/thermal/thermal_zone1/").c_str())) == nullptr) {
 		thd_log_info("Waiting for thermal sysfs to be ready\n");
 		sleep(2);
 	} else {
@@ -819,7 +1578,7 @@ void cthd_engine::thd_read_default_thermal_sensors() {
 	}
 
 	thd_log_debug("thd_read_default_thermal_sensors\n");
-	if ((dir = opendir(base_path.c_str())) != nullptr) {
+	if ((dir = opendir(csys_fs::map_path(base_path).c_str())) != nullptr) {
 		while ((entry = readdir(dir)) != nullptr) {
 			if (!strncmp(entry->d_name, "thermal_zone",
 					strlen("thermal_zone"))) {
@@ -851,7 +1610,7 @@ void cthd_engine::thd_read_default_thermal_zones() {
 	int max_index = 0;
 
 	thd_log_debug("thd_read_default_thermal_zones\n");
-	if ((dir = opendir(base_path.c_str())) != nullptr) {
+	if ((dir = opendir(csys_fs::map_path(base_path).c_str())) != nullptr) {
 		while ((entry = readdir(dir)) != nullptr) {
 			if (!strncmp(entry->d_name, "thermal_zone",
 					strlen("thermal_zone"))) {
@@ -885,7 +1644,7 @@ void cthd_engine::thd_read_default_cooling_devices() {
 	int max_index = 0;
 
 	thd_log_debug("thd_read_default_cooling devices\n");
-	if ((dir = opendir(base_path.c_str())) != nullptr) {
+	if ((dir = opendir(csys_fs::map_path(base_path).c_str())) != nullptr) {
 		while ((entry = readdir(dir)) != nullptr) {
 			if (!strncmp(entry->d_name, "cooling_device",
 					strlen("cooling_device"))) {
@@ -998,14 +1757,6 @@ cthd_sensor* cthd_engine::get_sensor(int index) {
 		return nullptr;
 }
 
-int cthd_engine::get_sensor_temperature(int index, unsigned int *temperature) {
-	if (index >= 0 && index < (int) sensors.size()) {
-		*temperature = sensors[index]->read_temperature();
-		return THD_SUCCESS;
-	} else
-		return THD_ERROR;
-}
-
 cthd_zone* cthd_engine::get_zone(int index) {
 	if (index == -1)
 		return nullptr;
@@ -1066,6 +1817,9 @@ int cthd_engine::user_add_sensor(std::string name, std::string path) {
 		if (sensors[i]->get_sensor_type() == name) {
 			cthd_sensor *sensor = sensors[i].get();
 			sensor->update_path(std::move(path));
+			thd_engine_reschedule();
+			snapshot_layout_dirty = true;
+			publish_snapshot(thd_get_monotonic_msec());
 			return THD_SUCCESS;
 		}
 	}
@@ -1076,6 +1830,7 @@ int cthd_engine::user_add_sensor(std::string name, std::string path) {
 	}
 	sensors.push_back(std::move(sensor));
 	++current_sensor_index;
+	publish_snapshot(thd_get_monotonic_msec());
 
 	send_message(WAKEUP, 0, nullptr);
 
@@ -1097,6 +1852,10 @@ int cthd_engine::user_add_virtual_sensor(std::string name,
 						(cthd_sensor_virtual *) sensor;
 				ret = virt_sensor->sensor_update_param(dep_sensor, slope,
 						intercept);
+				sensor_graph_dirty = true;
+				thd_engine_reschedule();
+				snapshot_layout_dirty = true;
+				publish_snapshot(thd_get_monotonic_msec());
 			} else {
 				return THD_ERROR;
 			}
@@ -1111,34 +1870,16 @@ int cthd_engine::user_add_virtual_sensor(std::string name,
 	}
 	sensors.push_back(std::move(virt_sensor));
 	++current_sensor_index;
+	sensor_graph_dirty = true;
+	thd_engine_reschedule();
+	snapshot_layout_dirty = true;
+	publish_snapshot(thd_get_monotonic_msec());
 
 	send_message(WAKEUP, 0, nullptr);
 
 	return THD_SUCCESS;
 }
 
-cthd_sensor *cthd_engine::user_get_sensor(unsigned int index) {
-
-	if (index < sensors.size())
-		return sensors[index].get();
-	else
-		return nullptr;
-}
-
-cthd_zone *cthd_engine::user_get_zone(unsigned int index) {
-	if (index < zones.size())
-		return zones[index].get();
-	else
-		return nullptr;
-}
-
-cthd_cdev *cthd_engine::user_get_cdev(unsigned int index) {
-	if (index < cdevs.size())
-		return cdevs[index].get();
-	else
-		return nullptr;
-}
-
 int cthd_engine::user_set_psv_temp(const std::string& name, unsigned int temp) {
 	cthd_zone *zone;
 	int ret;
@@ -1151,6 +1892,7 @@ int cthd_engine::user_set_psv_temp(const std::string& name, unsigned int temp) {
 	}
 	thd_log_info("Setting psv %u\n", temp);
 	ret = zone->update_psv_temperature(temp);
+	publish_snapshot(thd_get_monotonic_msec());
 
 	return ret;
 }
@@ -1167,6 +1909,7 @@ int cthd_engine::user_set_max_temp(const std::string& name, unsigned int temp) {
 	}
 	thd_log_info("Setting max %u\n", temp);
 	ret = zone->update_max_temperature(temp);
+	publish_snapshot(thd_get_monotonic_msec());
 
 	return ret;
 }
@@ -1193,6 +1936,11 @@ int cthd_engine::user_add_zone(std::string zone_name, unsigned int trip_temp,
 		zones[i]->zone_dump();
 	}
 
+	thd_engine_reschedule();
+	snapshot_layout_dirty = true;
+	publish_snapshot(thd_get_monotonic_msec());
+	send_message(WAKEUP, 0, nullptr);
+
 	return ret;
 }
 
@@ -1210,23 +1958,7 @@ int cthd_engine::user_set_zone_status(const std::string& name, int status) {
 		zone->set_zone_active();
 	else
 		zone->set_zone_inactive();
-
-	return THD_SUCCESS;
-}
-
-int cthd_engine::user_get_zone_status(const std::string& name, int *status) {
-	cthd_zone *zone;
-
-	std::lock_guard<std::mutex> guard(thd_engine_mutex);
-	zone = get_zone(name);
-	if (!zone) {
-		return THD_ERROR;
-	}
-
-	if (zone->zone_active_status())
-		*status = 1;
-	else
-		*status = 0;
+	publish_snapshot(thd_get_monotonic_msec());
 
 	return THD_SUCCESS;
 }
@@ -1236,6 +1968,9 @@ int cthd_engine::user_delete_zone(const std::string& name) {
 	for (unsigned int i = 0; i < zones.size(); ++i) {
 		if (zones[i]->get_zone_type() == name) {
 			zones.erase(zones.begin() + i);
+			thd_engine_reschedule();
+			snapshot_layout_dirty = true;
+			publish_snapshot(thd_get_monotonic_msec());
 			break;
 		}
 	}
@@ -1270,6 +2005,8 @@ int cthd_engine::user_add_cdev(std::string cdev_name, std::string cdev_path,
 	cdev->set_min_state(min_state);
 	cdev->set_max_state(max_state);
 	cdev->set_inc_dec_value(step);
+	snapshot_layout_dirty = true;
+	publish_snapshot(thd_get_monotonic_msec());
 
 	for (unsigned int i = 0; i < cdevs.size(); ++i) {
 		cdevs[i]->cdev_dump();
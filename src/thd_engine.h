@@ -25,8 +25,10 @@
 #ifndef THD_ENGINE_H_
 #define THD_ENGINE_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <pthread.h>
 #include <poll.h>
 #include <time.h>
@@ -41,35 +43,29 @@
 #include "thd_kobj_uevent.h"
 #include "thd_rapl_power_meter.h"
 #include "thd_features_parse.h"
+#include "thd_sample_scheduler.h"
+#include "thd_sensor_graph.h"
+#include "thd_timer_service.h"
+#include "thd_engine_stats.h"
+#include "thd_engine_snapshot.h"
+#include "thd_trace.h"
+#include "thd_telemetry.h"
+#include "thd_metrics.h"
+#include "thd_msg_queue.h"
 
-#define MAX_MSG_SIZE 		512
 #define THD_NUM_OF_POLL_FDS	10
 
-typedef enum : uint8_t {
-	WAKEUP,
-	TERMINATE,
-	PREF_CHANGED,
-	THERMAL_ZONE_NOTIFY,
-	RELOAD_ZONES,
-	POLL_ENABLE,
-	POLL_DISABLE,
-	FAST_POLL_ENABLE,
-	FAST_POLL_DISABLE,
-} message_name_t;
-
 // This defines whether the thermal control is entirely done by
 // this daemon or it just complements, what is done in kernel
 typedef enum : uint8_t {
 	COMPLEMENTRY, EXCLUSIVE,
 } control_mode_t;
 
-typedef struct {
-	message_name_t msg_id;
-	int msg_size;
-	unsigned long msg[MAX_MSG_SIZE];
-} message_capsul_t;
+class cthd_simulator;
 
 class cthd_engine {
+	// Runs engine loop iterations without the engine thread
+	friend class cthd_engine_bench;
 
 protected:
 	std::vector<std::unique_ptr<cthd_zone>> zones;
@@ -89,22 +85,17 @@ private:
 	int poll_timeout_msec;
 	int wakeup_fd;
 	int uevent_fd;
+	int timer_fd;
 	control_mode_t control_mode;
-	int write_pipe_fd;
+	cthd_msg_queue msg_queue;
 	int preference;
 	bool status;
-	time_t thz_last_uevent_time;
-	time_t thz_last_temp_ind_time;
-	time_t thz_last_update_event_time;
 	bool terminate;
 	int has_invariant_tsc;
 	int has_aperf;
 	bool proc_list_matched;
 	int poll_interval_sec;
 	cthd_preference thd_pref;
-	unsigned int poll_sensor_mask;
-	unsigned int fast_poll_sensor_mask;
-	int saved_poll_interval;
 	std::string config_file;
 
 	pthread_t thd_engine;
@@ -113,24 +104,78 @@ private:
 	std::mutex thd_engine_mutex;
 
 	std::vector<std::string> zone_preferences;
-	static constexpr int thz_notify_debounce_interval = 3;
+	static constexpr int thz_notify_debounce_interval = 3000; // In msec, per zone default
 
 	struct pollfd poll_fds[THD_NUM_OF_POLL_FDS];
 	int poll_fd_cnt;
 	bool rt_kernel;
 	cthd_kobj_uevent kobj_uevent;
 	bool parser_init_done;
+	cthd_sample_scheduler sample_scheduler;
+	std::atomic<bool> sample_schedule_dirty;
+	cthd_sensor_graph sensor_graph;
+	bool sensor_graph_dirty;
+	cthd_timer_service timer_service;
+	cthd_engine_stats stats;
+	cthd_trace trace;
+	cthd_telemetry telemetry;
+	cthd_metrics metrics;
+	int virt_sensor_timer;
+	int engine_state_timer;
+	csys_fs_snapshot sensor_snapshot;
+	std::vector<cthd_zone *> due_zones;
+	std::vector<int> snapshot_slots;
+	// thermal_zone number from uevent DEVPATH to zones using that sensor
+	std::unordered_map<int, std::vector<cthd_zone *>> uevent_zone_map;
+	// Sensor index to zones reading that sensor
+	std::unordered_map<int, std::vector<cthd_zone *>> sensor_zone_map;
+	std::vector<int> uevent_ids;
+	// Monotonic msec when the current sampling tick started
+	std::atomic<long long> sample_tick_time;
+	std::shared_ptr<const cthd_snapshot_layout> snapshot_layout;
+	std::atomic<bool> snapshot_layout_dirty;
+	std::shared_ptr<const cthd_engine_snapshot> snapshot;
+	std::mutex snapshot_mutex;
+	unsigned long snapshot_seq;
+	// Published snapshot, the previous one kept by the D-Bus signals and
+	// ones still held by readers. Reused once only the pool holds them.
+	static constexpr int snapshot_pool_size = 4;
+	std::shared_ptr<cthd_engine_snapshot> snapshot_pool[snapshot_pool_size];
+	// Called by publish_snapshot when values changed, outlives engines
+	static std::atomic<void (*)()> snapshot_notify;
 
 	int proc_message(message_capsul_t *msg);
+	int arm_sample_timer(long long deadline);
 	void process_pref_change();
 	void thermal_zone_change(message_capsul_t *msg);
 	void process_terminate();
 	void check_for_rt_kernel();
+	cthd_sensor *search_sensor_index(int index);
+	int get_sensor_sample_period(cthd_sensor *sensor);
+	int get_zone_sample_period(cthd_zone *zone);
+	void rebuild_sample_schedule(long long now);
+	void update_trace_names();
+	int thd_engine_replay(const std::string &path, int repeat);
+	void process_sample_schedule(long long now);
+	void sample_due_zones();
+	void add_due_zone(cthd_zone *zone);
+	void process_uevents(long long now);
+	void process_tick(long long now);
+	void process_messages();
+	long long get_next_wakeup();
+	void register_timers();
+	void build_snapshot_layout(unsigned int trip_count);
+	std::shared_ptr<cthd_engine_snapshot> get_free_snapshot();
+	void publish_snapshot(long long now);
+	void refresh_idle_sensors(long long older_than);
+	void write_metrics();
 
 public:
 	static constexpr int max_thermal_zones = 10;
 	static constexpr int max_cool_devs = 50;
 	static constexpr int def_poll_interval = 4000;
+	static constexpr int fast_poll_interval = 1000;
+	static constexpr int engine_state_timer_slack = 1000; // In msec
 	static constexpr int soft_cdev_start_index = 100;
 
 	cthd_parse parser;
@@ -150,6 +195,7 @@ public:
 	void thd_engine_thread();
 	virtual int thd_engine_init(bool ignore_cpuid_check, bool adaptive = false);
 	virtual int thd_engine_start();
+	int thd_engine_simulate(cthd_simulator &sim);
 	void thd_parse_features();
 	int thd_engine_stop();
 	int check_cpu_id();
@@ -164,6 +210,7 @@ public:
 
 	void poll_enable_disable(bool status, message_capsul_t *msg);
 	void fast_poll_enable_disable(bool status, message_capsul_t *msg);
+	void sensor_changed(message_capsul_t *msg);
 
 	cthd_cdev *thd_get_cdev_at_index(int index);
 
@@ -176,6 +223,7 @@ public:
 
 	void thd_engine_fast_poll_enable(int sensor_id);
 	void thd_engine_fast_poll_disable(int sensor_id);
+	void thd_engine_sensor_changed(int sensor_id);
 
 	void thd_read_default_thermal_sensors();
 	void thd_read_default_thermal_zones();
@@ -216,9 +264,36 @@ public:
 		return poll_timeout_msec / 1000;
 	}
 	void thd_engine_reload_zones();
+	// Caller must hold engine lock, when zones or their sensors change
+	void thd_engine_reschedule() {
+		sample_schedule_dirty = true;
+	}
 	bool processor_id_match() {
 		return proc_list_matched;
 	}
+	cthd_engine_stats &get_stats() {
+		return stats;
+	}
+	cthd_trace &get_trace() {
+		return trace;
+	}
+	void cdev_state_changed(cthd_cdev *cdev, int zone_id, int state);
+	void thd_engine_dump_stats(std::string &out);
+	// notify is called from the engine thread with the engine lock held
+	static void set_snapshot_notify(void (*notify)()) {
+		snapshot_notify.store(notify);
+	}
+	// Last published state, nullptr before the first tick. Readers use it
+	// instead of the engine objects and never take the engine lock.
+	std::shared_ptr<const cthd_engine_snapshot> get_snapshot() {
+		std::lock_guard<std::mutex> guard(snapshot_mutex);
+		return snapshot;
+	}
+	void thd_engine_log_stats();
+
+	long long get_sample_tick_time() {
+		return sample_tick_time.load(std::memory_order_acquire);
+	}
 	int get_poll_interval() {
 		return poll_interval_sec;
 	}
@@ -245,7 +320,6 @@ public:
 	cthd_sensor *get_sensor(int index);
 	cthd_zone *get_zone(int index);
 	cthd_zone *get_zone(const std::string& type);
-	int get_sensor_temperature(int index, unsigned int *temperature);
 
 	unsigned int get_sensor_count() {
 		return sensors.size();
@@ -280,8 +354,6 @@ public:
 
 	// User/External messages
 	int user_add_sensor(std::string name, std::string path);
-	cthd_sensor *user_get_sensor(unsigned int index);
-	cthd_zone *user_get_zone(unsigned int index);
 	int user_add_virtual_sensor(std::string name, std::string dep_sensor,
 			double slope, double intercept);
 
@@ -290,12 +362,10 @@ public:
 	int user_add_zone(std::string zone_name, unsigned int trip_temp,
 			std::string sensor_name, std::string cdev_name);
 	int user_set_zone_status(const std::string& name, int status);
-	int user_get_zone_status(const std::string& name, int *status);
 	int user_delete_zone(const std::string& name);
 
 	int user_add_cdev(std::string cdev_name, std::string cdev_path,
 			int min_state, int max_state, int step);
-	cthd_cdev *user_get_cdev(unsigned int index);
 
 	void enable_power_floor_event();
 	int parser_init();
@@ -106,7 +106,7 @@ int cthd_engine_default::read_thermal_sensors() {
 	// Default CPU temperature zone
 	// Find path to read DTS temperature
 	for (i = 0; i < 2; ++i) {
-		if ((dir = opendir(base_path[i].c_str())) != nullptr) {
+		if ((dir = opendir(csys_fs::map_path(base_path[i]).c_str())) != nullptr) {
 			while ((entry = readdir(dir)) != nullptr) {
 				if (!strncmp(entry->d_name, "coretemp.", strlen("coretemp."))
 						|| !strncmp(entry->d_name, "hwmon", strlen("hwmon"))) {
@@ -136,7 +136,8 @@ int cthd_engine_default::read_thermal_sensors() {
 					int len_temp_dir_entry = 0;
 					int len_input = strlen("_input");
 
-					if ((temp_dir = opendir(temp_dir_path.c_str())) != nullptr) {
+					if ((temp_dir = opendir(
+							csys_fs::map_path(temp_dir_path).c_str())) != nullptr) {
 						while ((temp_dir_entry = readdir(temp_dir)) != nullptr) {
 							len_temp_dir_entry = strlen(temp_dir_entry->d_name);
 							if ((len_temp_dir_entry >= len_input
@@ -415,7 +416,7 @@ int cthd_engine_default::read_thermal_zones() {
 		// Default CPU temperature zone
 		// Find path to read DTS temperature
 		for (i = 0; i < 2; ++i) {
-			if ((dir = opendir(base_path[i].c_str())) != nullptr) {
+			if ((dir = opendir(csys_fs::map_path(base_path[i]).c_str())) != nullptr) {
 				while ((entry = readdir(dir)) != nullptr) {
 					if (!strncmp(entry->d_name, "coretemp.",
 							strlen("coretemp."))
@@ -590,6 +591,12 @@ int cthd_engine_default::read_thermal_zones() {
 					zones.push_back(std::move(zone));
 				}
 			}
+			if (zone_config->uevent_debounce > 0) {
+				cthd_zone *_zone = search_zone(zone_config->type);
+				if (_zone)
+					_zone->set_uevent_debounce_interval(
+							zone_config->uevent_debounce);
+			}
 			disable_cpu_zone(zone_config);
 		}
 	}
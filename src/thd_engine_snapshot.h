@@ -0,0 +1,97 @@
+/*
+ * thd_engine_snapshot.h: engine state published once per tick for readers
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_ENGINE_SNAPSHOT_H_
+#define THD_ENGINE_SNAPSHOT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef struct {
+	int index;
+	std::string type;
+	std::string path;
+} thd_snapshot_sensor_t;
+
+typedef struct {
+	int type;
+	int sensor_id;
+	std::vector<int> cdev_ids;
+} thd_snapshot_trip_t;
+
+typedef struct {
+	int index;
+	std::string type;
+	std::vector<std::string> sensors;
+	std::vector<thd_snapshot_trip_t> trips;
+	unsigned int first_trip; // of the zone in the per tick trip values
+} thd_snapshot_zone_t;
+
+typedef struct {
+	int index;
+	std::string type;
+	int min_state;
+	int max_state;
+	bool power_limit;
+} thd_snapshot_cdev_t;
+
+// Names and bindings of the engine objects. They rarely change, so a
+// layout is shared by all snapshots until sensors, zones or cdevs change.
+class cthd_snapshot_layout {
+public:
+	std::vector<thd_snapshot_sensor_t> sensors;
+	std::vector<thd_snapshot_zone_t> zones;
+	std::vector<thd_snapshot_cdev_t> cdevs;
+	unsigned int trip_count;
+
+	cthd_snapshot_layout() :
+			trip_count(0) {
+	}
+};
+
+// Values of one tick, in layout order. Immutable once published, readers
+// keep their reference as long as they need it without any engine lock.
+class cthd_engine_snapshot {
+public:
+	unsigned long seq;
+	long long time; // monotonic msec of the tick
+	std::shared_ptr<const cthd_snapshot_layout> layout;
+	std::vector<unsigned int> sensor_temps;
+	// Monotonic msec of the last sample, 0 if never sampled
+	std::vector<long long> sensor_times;
+	std::vector<unsigned int> zone_temps;
+	std::vector<bool> zone_active;
+	// Trips of all zones
+	std::vector<int> trip_temps;
+	std::vector<bool> trip_on;
+	std::vector<unsigned long> trip_crossings;
+	std::vector<int> cdev_states;
+
+	cthd_engine_snapshot() :
+			seq(0), time(0) {
+	}
+};
+
+#endif /* THD_ENGINE_SNAPSHOT_H_ */
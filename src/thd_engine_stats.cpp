@@ -0,0 +1,138 @@
+/*
+ * thd_engine_stats.cpp: engine loop instrumentation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#include "thd_engine_stats.h"
+
+cthd_latency_histogram::cthd_latency_histogram() :
+		total_count(0), total_usec(0), max_usec(0) {
+	for (int i = 0; i < bucket_count; ++i)
+		counts[i].store(0, std::memory_order_relaxed);
+}
+
+int cthd_latency_histogram::bucket_index(long long usec) {
+	if (usec < 0)
+		usec = 0;
+	if (usec >= (1LL << max_value_bits))
+		usec = (1LL << max_value_bits) - 1;
+
+	if (usec < sub_buckets)
+		return (int) usec;
+
+	int msb = 63 - __builtin_clzll((unsigned long long) usec);
+	int shift = msb - sub_bucket_bits;
+
+	return (shift + 1) * sub_buckets + (int) ((usec >> shift) & (sub_buckets - 1));
+}
+
+// Largest value which falls in this bucket
+long long cthd_latency_histogram::bucket_high(int index) {
+	if (index < sub_buckets)
+		return index;
+
+	int shift = index / sub_buckets - 1;
+	long long low = (long long) (sub_buckets + index % sub_buckets) << shift;
+
+	return low + (1LL << shift) - 1;
+}
+
+void cthd_latency_histogram::record(long long usec) {
+	counts[bucket_index(usec)].fetch_add(1, std::memory_order_relaxed);
+	total_count.fetch_add(1, std::memory_order_relaxed);
+	total_usec.fetch_add(usec, std::memory_order_relaxed);
+
+	long long max = max_usec.load(std::memory_order_relaxed);
+	while (usec > max
+			&& !max_usec.compare_exchange_weak(max, usec,
+					std::memory_order_relaxed))
+		;
+}
+
+// Upper bound of the value below which pct percent of samples fall
+long long cthd_latency_histogram::percentile(double pct) {
+	unsigned long count = total_count.load(std::memory_order_relaxed);
+	unsigned long sum = 0;
+
+	if (!count)
+		return 0;
+
+	unsigned long target = (unsigned long) (count * pct / 100.0);
+	if (target < 1)
+		target = 1;
+
+	for (int i = 0; i < bucket_count; ++i) {
+		sum += counts[i].load(std::memory_order_relaxed);
+		if (sum >= target)
+			return bucket_high(i);
+	}
+
+	return get_max();
+}
+
+long long cthd_latency_histogram::get_avg() {
+	unsigned long count = get_count();
+
+	if (!count)
+		return 0;
+
+	return total_usec.load(std::memory_order_relaxed) / (long long) count;
+}
+
+void cthd_latency_histogram::cumulative_counts(const long long *bounds,
+		int bound_count, unsigned long *counts_out, unsigned long *count) {
+	unsigned long sum = 0;
+	int bound = 0;
+
+	for (int i = 0; i < bucket_count; ++i) {
+		while (bound < bound_count && bucket_high(i) > bounds[bound])
+			counts_out[bound++] = sum;
+		sum += counts[i].load(std::memory_order_relaxed);
+	}
+	while (bound < bound_count)
+		counts_out[bound++] = sum;
+
+	*count = sum;
+}
+
+const char *cthd_engine_stats::stage_name(int stage) {
+	static const char *names[STAT_STAGE_COUNT] = { "tick", "rapl", "timers",
+			"zones", "trips", "cdev", "engine_state", "messages",
+			"discovery" };
+
+	if (stage < 0 || stage >= STAT_STAGE_COUNT)
+		return "invalid";
+
+	return names[stage];
+}
+
+void cthd_engine_stats::dump(std::ostringstream &out) {
+	out << "stage count avg_us p50_us p99_us p999_us max_us\n";
+	for (int i = 0; i < STAT_STAGE_COUNT; ++i) {
+		cthd_latency_histogram &hist = stages[i];
+
+		out << stage_name(i) << " " << hist.get_count() << " "
+				<< hist.get_avg() << " " << hist.percentile(50) << " "
+				<< hist.percentile(99) << " " << hist.percentile(99.9) << " "
+				<< hist.get_max() << "\n";
+	}
+}
@@ -0,0 +1,116 @@
+/*
+ * thd_engine_stats.h: engine loop instrumentation interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_ENGINE_STATS_H_
+#define THD_ENGINE_STATS_H_
+
+#include <atomic>
+#include <sstream>
+#include "thd_util.h"
+
+typedef enum {
+	STAT_TICK,		// One engine loop iteration after poll() returns
+	STAT_RAPL,		// RAPL energy counter reads
+	STAT_TIMERS,	// Shared timer callbacks
+	STAT_ZONES,		// Sampling of due zones
+	STAT_TRIPS,		// Trip checks of one zone sensor, nested in zones
+	STAT_CDEV,		// Cooling device state change, nested in trips
+	STAT_ENGINE_STATE, // update_engine_state()
+	STAT_MESSAGES,	// Engine message processing
+	STAT_DISCOVERY,	// Reading sensors, cdevs and zones from sysfs
+	STAT_STAGE_COUNT
+} thd_stat_stage_t;
+
+// Log-linear histogram of durations in usec, like HDR histograms: each
+// power of 2 range is split into 8 buckets, so the error is below 12.5%.
+class cthd_latency_histogram {
+private:
+	static constexpr int sub_bucket_bits = 3;
+	static constexpr int sub_buckets = 1 << sub_bucket_bits;
+	static constexpr int max_value_bits = 41;
+	static constexpr int bucket_count = (max_value_bits - sub_bucket_bits + 1)
+			* sub_buckets;
+
+	std::atomic<unsigned long> counts[bucket_count];
+	std::atomic<unsigned long> total_count;
+	std::atomic<long long> total_usec;
+	std::atomic<long long> max_usec;
+
+	static int bucket_index(long long usec);
+	static long long bucket_high(int index);
+
+public:
+	cthd_latency_histogram();
+
+	void record(long long usec);
+	long long percentile(double pct);
+	unsigned long get_count() {
+		return total_count.load(std::memory_order_relaxed);
+	}
+	long long get_max() {
+		return max_usec.load(std::memory_order_relaxed);
+	}
+	long long get_avg();
+	long long get_sum() {
+		return total_usec.load(std::memory_order_relaxed);
+	}
+	// Samples at most bounds[i] usec into counts[i], all samples into *count,
+	// from one pass so the cumulative counts are consistent
+	void cumulative_counts(const long long *bounds, int bound_count,
+			unsigned long *counts_out, unsigned long *count);
+};
+
+class cthd_engine_stats {
+private:
+	cthd_latency_histogram stages[STAT_STAGE_COUNT];
+
+public:
+	static const char *stage_name(int stage);
+
+	void record(thd_stat_stage_t stage, long long usec) {
+		stages[stage].record(usec);
+	}
+	void dump(std::ostringstream &out);
+	cthd_latency_histogram &get_histogram(thd_stat_stage_t stage) {
+		return stages[stage];
+	}
+};
+
+// Record the lifetime of this object to a stage
+class cthd_stat_timer {
+private:
+	cthd_engine_stats &stats;
+	thd_stat_stage_t stage;
+	long long start;
+
+public:
+	cthd_stat_timer(cthd_engine_stats &_stats, thd_stat_stage_t _stage) :
+			stats(_stats), stage(_stage), start(thd_get_monotonic_nsec()) {
+	}
+	~cthd_stat_timer() {
+		stats.record(stage, (thd_get_monotonic_nsec() - start) / 1000);
+	}
+};
+
+#endif /* THD_ENGINE_STATS_H_ */
@@ -51,6 +51,8 @@ cthd_features_parse::cthd_features_parse() :
 		doc(nullptr), root_element(nullptr) {
 	std::string name = TDCONFDIR;
 	filename = name + "/" "thermald-features.xml";
+	// All features are supported without a features file
+	feature_list.assign(MAX_FEATURE, 1);
 }
 
 int cthd_features_parse::parser_init() {
@@ -86,9 +88,6 @@ int cthd_features_parse::parser_init() {
 		return THD_ERROR;
 	}
 
-	// Init all features as supported
-	feature_list.assign(MAX_FEATURE, 1);
-
 	if (stat(filename.c_str(), &s))
 		return THD_ERROR;
 
@@ -33,6 +33,7 @@
 #include <sstream>
 #include <sys/types.h>
 #include "thd_gddv.h"
+#include "thd_util.h"
 
 /* From esif_lilb_datavault.h */
 #define ESIFDV_NAME_LEN				32	// Max DataVault Name (Cache Name) Length (not including nullptr)
@@ -1439,7 +1440,7 @@ int cthd_gddv::compare_condition(const struct condition& condition,
 }
 
 int cthd_gddv::compare_time(const struct condition& condition) {
-	int elapsed = time(nullptr) - condition.state_entry_time;
+	int elapsed = thd_get_monotonic_msec() / 1000 - condition.state_entry_time;
 
 	switch (condition.time_comparison) {
 	case ADAPTIVE_EQUAL:
@@ -1623,7 +1624,9 @@ int cthd_gddv::evaluate_ac_condition(const struct condition& condition) {
 #else
 int cthd_gddv::evaluate_ac_condition(const struct condition& condition) {
 	int value = 0;
-	bool on_battery = up_client_get_on_battery(upower_client);
+	// Without upower, as when it failed to connect, assume AC
+	bool on_battery = upower_client
+			&& up_client_get_on_battery(upower_client);
 
 	if (on_battery)
 		value = 1;
@@ -1697,7 +1700,7 @@ int cthd_gddv::evaluate_condition(struct condition& condition) {
 		if (condition.time) {
 			thd_log_debug("time condition matched %ld \n", condition.state_entry_time);
 			if (condition.state_entry_time == 0) {
-				condition.state_entry_time = time(nullptr);
+				condition.state_entry_time = thd_get_monotonic_msec() / 1000;
 				return THD_ERROR;
 			} else {
 				ret = compare_time(condition);
@@ -1897,28 +1900,32 @@ unsigned int cthd_gddv::crc32(char const *p, unsigned int len)
 int cthd_gddv::format_dv_filename(std::stringstream& file_name)
 {
 	std::string sys_vendor;
-	std::ifstream product_sys_vendor("/sys/class/dmi/id/sys_vendor");
+	std::ifstream product_sys_vendor(
+			csys_fs::map_path("/sys/class/dmi/id/sys_vendor"));
 	if (!product_sys_vendor || !getline(product_sys_vendor, sys_vendor)) {
 		thd_log_info("Can't read sys_vendor\n");
 		return THD_ERROR;
 	}
 
 	std::string product_name;
-	std::ifstream product_product_name("/sys/class/dmi/id/product_name");
+	std::ifstream product_product_name(
+			csys_fs::map_path("/sys/class/dmi/id/product_name"));
 	if (!product_product_name || !getline(product_product_name, product_name)) {
 		thd_log_info("Can't read product_name\n");
 		return THD_ERROR;
 	}
 
 	std::string product_family;
-	std::ifstream product_product_family("/sys/class/dmi/id/product_family");
+	std::ifstream product_product_family(
+			csys_fs::map_path("/sys/class/dmi/id/product_family"));
 	if (!product_product_family || !getline(product_product_family, product_family)) {
 		thd_log_info("Can't read product_family\n");
 		return THD_ERROR;
 	}
 
 	std::string product_sku;
-	std::ifstream product_product_sku("/sys/class/dmi/id/product_sku");
+	std::ifstream product_product_sku(
+			csys_fs::map_path("/sys/class/dmi/id/product_sku"));
 	if (!product_product_sku || !getline(product_product_sku, product_sku)) {
 		thd_log_info("Can't read product_sku\n");
 		return THD_ERROR;
@@ -2063,6 +2070,26 @@ std::unique_ptr<char[]> cthd_gddv::gddv_load(size_t *size)
 	return data_buffer;
 }
 
+// Parse a data vault image of the INT3400 device at base_path
+int cthd_gddv::parse_data_vault(const std::string &base_path, char *buf,
+		size_t size) {
+	int3400_base_path = base_path;
+
+	try {
+		if (parse_gddv(buf, size, nullptr)) {
+			thd_log_debug("Unable to parse GDDV");
+			return THD_FATAL_ERROR;
+		}
+
+		merge_appc();
+	} catch (std::exception &e) {
+		thd_log_warn("%s\n", e.what());
+		return THD_FATAL_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
 int cthd_gddv::gddv_init(std::string& base_path) {
 	csys_fs sysfs("");
 	size_t size;
@@ -2100,27 +2127,18 @@ int cthd_gddv::gddv_init(std::string& base_path) {
 	}
 
 skip_load:
-	try {
-		if (parse_gddv(buf.get(), size, nullptr)) {
-			thd_log_debug("Unable to parse GDDV");
-			return THD_FATAL_ERROR;
-		}
-
-		merge_appc();
-
-		dump_ppcc();
-		dump_psvt();
-		dump_itmt();
-		dump_apat();
-		dump_apct();
-		dump_idsps();
-		dump_trips();
-		dump_vsct();
-		dump_vspt();
-	} catch (std::exception &e) {
-		thd_log_warn("%s\n", e.what());
+	if (parse_data_vault(base_path, buf.get(), size) != THD_SUCCESS)
 		return THD_FATAL_ERROR;
-	}
+
+	dump_ppcc();
+	dump_psvt();
+	dump_itmt();
+	dump_apat();
+	dump_apct();
+	dump_idsps();
+	dump_trips();
+	dump_vsct();
+	dump_vspt();
 
 #ifndef ANDROID
 	setup_input_devices();
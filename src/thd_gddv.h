@@ -301,6 +301,8 @@ public:
 
 	ppcc_t* get_ppcc_param(const std::string& name);
 	int gddv_init(std::string& base_path);
+	int parse_data_vault(const std::string &base_path, char *buf,
+			size_t size);
 	std::unique_ptr<char[]> gddv_load(size_t *size);
 	void gddv_free(void);
 	int verify_conditions();
@@ -83,6 +83,9 @@ void cthd_INT3400::set_default_uuid(void) {
 
 	std::string filename = base_path + "uuids/" + "current_uuid";
 
+	if (csys_fs::is_dry_run())
+		return;
+
 	std::ofstream ofs(filename.c_str(), std::ofstream::out);
 	if (ofs.good()) {
 		thd_log_info("Set Default UUID: %s\n", uuid.c_str());
@@ -104,6 +107,9 @@ int cthd_INT3400::set_policy_osc(void) {
 			if (line == "UNKNOWN") {
 				std::string _filename = base_path + "uuids/" + "current_uuid";
 
+				if (csys_fs::is_dry_run())
+					return THD_SUCCESS;
+
 				std::ofstream ofs(_filename.c_str(), std::ofstream::out);
 				if (ofs.good()) {
 					std::string _uuid = "42A441D6-AE6A-462b-A84B-4A8CE79027D3";
@@ -49,23 +49,26 @@ void cthd_kobj_uevent::kobj_uevent_close() {
 	close(fd);
 }
 
-bool cthd_kobj_uevent::check_for_event() {
+// Check DEVPATH against the registered path. The number following the
+// registered path, like N in thermal_zoneN, is returned in id or -1.
+bool cthd_kobj_uevent::match_event(char *buffer, ssize_t len, int *id) {
 	ssize_t i = 0;
-	ssize_t len;
 	const char *dev_path = "DEVPATH=";
 	unsigned int dev_path_len = strlen(dev_path);
-	char buffer[max_buffer_size];
+	unsigned int device_path_len = strlen(device_path);
 
-	len = recv(fd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
-	if (len <= 0)
-		return false;
 	buffer[len] = '\0';
-
 	while (i < len) {
 		if (strlen(buffer + i) > dev_path_len
 				&& !strncmp(buffer + i, dev_path, dev_path_len)) {
-			if (!strncmp(buffer + i + dev_path_len, device_path,
-					strlen(device_path))) {
+			const char *path = buffer + i + dev_path_len;
+
+			if (!strncmp(path, device_path, device_path_len)) {
+				char *end;
+				long val = strtol(path + device_path_len, &end, 10);
+
+				*id = (end != path + device_path_len && val >= 0) ?
+						(int) val : -1;
 				return true;
 			}
 		}
@@ -75,6 +78,54 @@ bool cthd_kobj_uevent::check_for_event() {
 	return false;
 }
 
+bool cthd_kobj_uevent::check_for_event() {
+	ssize_t len;
+	char buffer[max_buffer_size];
+	int id;
+
+	len = recv(fd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
+	if (len <= 0)
+		return false;
+
+	return match_event(buffer, len, &id);
+}
+
+// Drain all queued uevents in batches. For every matching event its id is
+// appended to ids. Returns the number of matching events.
+int cthd_kobj_uevent::read_events(std::vector<int> &ids) {
+	struct mmsghdr msgs[max_batch];
+	struct iovec iovecs[max_batch];
+	int matched = 0;
+
+	for (;;) {
+		memset(msgs, 0, sizeof(msgs));
+		for (int i = 0; i < max_batch; ++i) {
+			iovecs[i].iov_base = batch_buffers[i];
+			iovecs[i].iov_len = max_buffer_size - 1;
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int count = recvmmsg(fd, msgs, max_batch, MSG_DONTWAIT, nullptr);
+		if (count <= 0)
+			break;
+
+		for (int i = 0; i < count; ++i) {
+			int id;
+
+			if (match_event(batch_buffers[i], msgs[i].msg_len, &id)) {
+				ids.push_back(id);
+				++matched;
+			}
+		}
+
+		if (count < max_batch)
+			break;
+	}
+
+	return matched;
+}
+
 void cthd_kobj_uevent::register_dev_path(char *path) {
 	strncpy(device_path, path, max_buffer_size);
 	device_path[max_buffer_size - 1] = '\0';
@@ -33,16 +33,22 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <vector>
+
 #include <linux/types.h>
 #include <linux/netlink.h>
 
 class cthd_kobj_uevent {
 private:
 	static constexpr int max_buffer_size = 512;
+	static constexpr int max_batch = 16;
 
 	struct sockaddr_nl nls;
 	int fd;
 	char device_path[max_buffer_size];
+	char batch_buffers[max_batch][max_buffer_size];
+
+	bool match_event(char *buffer, ssize_t len, int *id);
 
 public:
 	cthd_kobj_uevent() {
@@ -54,6 +60,7 @@ public:
 	void kobj_uevent_close();
 	void register_dev_path(char *path);
 	bool check_for_event();
+	int read_events(std::vector<int> &ids);
 }
 ;
 
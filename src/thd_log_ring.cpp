@@ -0,0 +1,473 @@
+/*
+ * thd_log_ring.cpp: deferred logging ring implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* thd_log_info() and thd_log_debug() are called from trip checks and cdev
+ * state changes on every sampling tick. Formatting them with g_log() costs
+ * more than the control work itself, even when the level is filtered out.
+ * Instead the caller only copies the format pointer and the arguments to a
+ * slot in the ring. Format strings are literals, so the pointer stays valid;
+ * strings passed with %s are copied, as their lifetime is not known.
+ * Producers claim slots with one fetch_add and publish them with a sequence
+ * number, so any thread can log without a lock. A drainer thread formats
+ * the records of enabled levels, it sleeps until one is added. Lines keep
+ * the time they were logged. Warnings and errors are logged synchronously,
+ * thd_logger() flushes the ring before them to keep the output in order.
+ * On a crash the whole ring is written out, including info records when
+ * the info level is disabled.
+ */
+
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "thd_common.h"
+#include "thd_log_ring.h"
+#include "thd_sys_fs.h"
+#include "thd_util.h"
+
+// Set before the crash handlers are installed, they can't allocate
+static char crash_dump_file[PATH_MAX] = TDRUNDIR "/thd_log_ring.dump";
+
+cthd_log_ring::cthd_log_ring() :
+		head(0), drain_pos(0), level_mask(0), writer(nullptr), drainer_running(
+				false), drainer(0), drain_pending(false) {
+	for (unsigned int i = 0; i < ring_size; ++i)
+		ring[i].seq.store(0, std::memory_order_relaxed);
+}
+
+void cthd_log_ring::record(int level, const char *fmt, va_list args) {
+	int mask = level_mask.load(std::memory_order_relaxed);
+
+	// Debug records are the bulk of every tick, only info is kept for dumps
+	if (!(level & mask) && level == G_LOG_LEVEL_DEBUG)
+		return;
+
+	uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+	log_slot_t &slot = ring[pos & (ring_size - 1)];
+	log_record_t &rec = slot.rec;
+	int str_len = 0;
+
+	slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	rec.time_ns = thd_get_monotonic_nsec();
+	rec.level = level;
+	rec.fmt = fmt;
+	rec.nargs = 0;
+	rec.truncated = false;
+
+	for (const char *f = fmt; *f; ++f) {
+		if (*f != '%')
+			continue;
+		++f;
+		if (*f == '%')
+			continue;
+
+		while (*f && strchr("-+ #0'", *f))
+			++f;
+		while (isdigit(*f) || *f == '.')
+			++f;
+		// Variable width is not used by thermald, don't record it
+		if (!*f || *f == '*' || rec.nargs >= max_args) {
+			rec.truncated = true;
+			break;
+		}
+
+		int longs = 0;
+		bool long_double = false;
+		while (*f && strchr("hlLqjzt", *f)) {
+			if (*f == 'l' || *f == 'q')
+				++longs;
+			else if (*f == 'j' || *f == 'z' || *f == 't')
+				longs = 1;
+			else if (*f == 'L')
+				long_double = true;
+			++f;
+		}
+
+		int i = rec.nargs;
+		bool recorded = true;
+		bool stop = false;
+
+		switch (*f) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'c':
+			if (longs >= 2) {
+				rec.types[i] = ARG_LONG_LONG;
+				rec.args[i].i = va_arg(args, long long);
+			} else if (longs == 1) {
+				rec.types[i] = ARG_LONG;
+				rec.args[i].i = va_arg(args, long);
+			} else {
+				rec.types[i] = ARG_INT;
+				rec.args[i].i = va_arg(args, int);
+			}
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			rec.types[i] = ARG_DOUBLE;
+			if (long_double)
+				rec.args[i].d = (double) va_arg(args, long double);
+			else
+				rec.args[i].d = va_arg(args, double);
+			break;
+		case 'p':
+			rec.types[i] = ARG_PTR;
+			rec.args[i].p = va_arg(args, void *);
+			break;
+		case 's': {
+			const char *str = va_arg(args, const char *);
+			int len;
+
+			if (!str)
+				str = "(null)";
+			if (str_len >= str_buf_size) {
+				recorded = false;
+				stop = true;
+				break;
+			}
+			len = strlen(str);
+			if (len > str_buf_size - 1 - str_len) {
+				len = str_buf_size - 1 - str_len;
+				stop = true;
+			}
+			rec.types[i] = ARG_STR;
+			rec.args[i].str_offset = str_len;
+			memcpy(rec.str_buf + str_len, str, len);
+			str_len += len;
+			rec.str_buf[str_len++] = '\0';
+			break;
+		}
+		default:
+			// %n or unknown conversion
+			recorded = false;
+			stop = true;
+			break;
+		}
+		if (recorded)
+			rec.nargs = i + 1;
+		if (stop) {
+			rec.truncated = true;
+			break;
+		}
+	}
+
+	slot.seq.store(2 * pos + 2, std::memory_order_release);
+
+	// One wakeup per batch, the drainer clears the flag before draining
+	if ((level & mask) && !drain_pending.exchange(true)) {
+		std::lock_guard<std::mutex> guard(wake_lock);
+		wake_cond.notify_one();
+	}
+}
+
+// Format one conversion at a time, with the spec copied from the format
+int cthd_log_ring::format_record(const log_record_t &rec, char *buf,
+		int size) {
+	const char *f = rec.fmt;
+	int len = 0;
+	int arg = 0;
+
+	while (*f && len < size - 1) {
+		if (*f != '%') {
+			buf[len++] = *f++;
+			continue;
+		}
+		if (f[1] == '%') {
+			buf[len++] = '%';
+			f += 2;
+			continue;
+		}
+		if (arg >= rec.nargs)
+			break;
+
+		const char *start = f++;
+		while (*f && strchr("-+ #0'", *f))
+			++f;
+		while (isdigit(*f) || *f == '.')
+			++f;
+		while (*f && strchr("hlLqjzt", *f))
+			++f;
+		if (!*f)
+			break;
+		++f;
+
+		char spec[32];
+		int spec_len = f - start;
+		if (spec_len >= (int) sizeof(spec))
+			break;
+		memcpy(spec, start, spec_len);
+		spec[spec_len] = '\0';
+
+		// Length modifiers in spec match the recorded type
+		int ret;
+		switch (rec.types[arg]) {
+		case ARG_INT:
+			ret = snprintf(buf + len, size - len, spec, (int) rec.args[arg].i);
+			break;
+		case ARG_LONG:
+			ret = snprintf(buf + len, size - len, spec, (long) rec.args[arg].i);
+			break;
+		case ARG_LONG_LONG:
+			ret = snprintf(buf + len, size - len, spec, rec.args[arg].i);
+			break;
+		case ARG_DOUBLE:
+			if (strchr(spec, 'L'))
+				ret = snprintf(buf + len, size - len, spec,
+						(long double) rec.args[arg].d);
+			else
+				ret = snprintf(buf + len, size - len, spec, rec.args[arg].d);
+			break;
+		case ARG_PTR:
+			ret = snprintf(buf + len, size - len, spec, rec.args[arg].p);
+			break;
+		case ARG_STR:
+		default:
+			ret = snprintf(buf + len, size - len, spec,
+					rec.str_buf + rec.args[arg].str_offset);
+			break;
+		}
+		if (ret < 0)
+			break;
+		len += ret;
+		if (len > size - 1)
+			len = size - 1;
+		++arg;
+	}
+
+	if (rec.truncated && len < size - 5) {
+		if (len && buf[len - 1] == '\n')
+			--len;
+		len += snprintf(buf + len, size - len, "...\n");
+	}
+	buf[len] = '\0';
+
+	return len;
+}
+
+cthd_log_ring::read_status_t cthd_log_ring::read_record(uint64_t pos,
+		log_record_t *rec) {
+	log_slot_t &slot = ring[pos & (ring_size - 1)];
+	uint64_t seq = slot.seq.load(std::memory_order_acquire);
+
+	if (seq < 2 * pos + 2)
+		return READ_PENDING;
+	if (seq > 2 * pos + 2)
+		return READ_LOST;
+
+	*rec = slot.rec;
+
+	// The writer of a later record may have overwritten the copy
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot.seq.load(std::memory_order_relaxed) != seq)
+		return READ_LOST;
+
+	return READ_OK;
+}
+
+void cthd_log_ring::drain() {
+	std::unique_lock<std::mutex> guard(drain_lock);
+	uint64_t end = head.load(std::memory_order_acquire);
+	unsigned long lost = 0;
+	int mask = level_mask.load(std::memory_order_relaxed);
+	log_record_t rec;
+	char buf[1024];
+	struct timespec wall;
+
+	if (!(mask & (G_LOG_LEVEL_INFO | G_LOG_LEVEL_DEBUG))) {
+		drain_pos = end;
+		return;
+	}
+
+	// Record times are monotonic, print them as wall clock
+	clock_gettime(CLOCK_REALTIME, &wall);
+	long long offset_ns = wall.tv_sec * 1000000000LL + wall.tv_nsec
+			- thd_get_monotonic_nsec();
+
+	if (end - drain_pos > ring_size) {
+		lost += end - drain_pos - ring_size;
+		drain_pos = end - ring_size;
+	}
+
+	for (; drain_pos < end; ++drain_pos) {
+		read_status_t status = read_record(drain_pos, &rec);
+
+		if (status == READ_PENDING)
+			break;
+		if (status == READ_LOST) {
+			++lost;
+			continue;
+		}
+		if (!(rec.level & mask))
+			continue;
+
+		format_record(rec, buf, sizeof(buf));
+		if (writer)
+			writer(rec.level, (rec.time_ns + offset_ns) / 1000000000LL, buf);
+		else
+			g_log(nullptr, (GLogLevelFlags) rec.level, "%s", buf);
+	}
+	guard.unlock();
+
+	if (lost)
+		thd_log_warn("log ring overrun, %lu records lost\n", lost);
+}
+
+void *cthd_log_ring::drainer_thread(void *arg) {
+	cthd_log_ring *log_ring = (cthd_log_ring *) arg;
+
+	while (log_ring->drainer_running.load(std::memory_order_relaxed)) {
+		{
+			std::unique_lock<std::mutex> lock(log_ring->wake_lock);
+			log_ring->wake_cond.wait(lock, [log_ring] {
+				return log_ring->drain_pending.load();
+			});
+		}
+		log_ring->drain_pending.store(false);
+		log_ring->drain();
+	}
+
+	return nullptr;
+}
+
+int cthd_log_ring::start_drainer() {
+	pthread_attr_t attr;
+
+	if (drainer_running.load())
+		return THD_SUCCESS;
+
+	drainer_running.store(true);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&drainer, &attr, drainer_thread, this)) {
+		drainer_running.store(false);
+		pthread_attr_destroy(&attr);
+		return THD_ERROR;
+	}
+	pthread_attr_destroy(&attr);
+
+	return THD_SUCCESS;
+}
+
+// Called from signal handlers: no locks and no allocations
+void cthd_log_ring::write_out(int fd, const log_record_t &rec) {
+	char buf[1024];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "[%lld.%06lld]%s",
+			rec.time_ns / 1000000000LL, (rec.time_ns / 1000) % 1000000LL,
+			rec.level == G_LOG_LEVEL_DEBUG ? "[DEBUG]" : "[INFO]");
+	len += format_record(rec, buf + len, sizeof(buf) - len);
+
+	if (write(fd, buf, len) < 0)
+		return;
+}
+
+void cthd_log_ring::dump(int fd) {
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t pos = end > ring_size ? end - ring_size : 0;
+	log_record_t rec;
+
+	for (; pos < end; ++pos) {
+		if (read_record(pos, &rec) == READ_OK)
+			write_out(fd, rec);
+	}
+}
+
+static cthd_log_ring &get_log_ring() {
+	static cthd_log_ring log_ring;
+
+	return log_ring;
+}
+
+void thd_log_ring_record(int level, const char *fmt, ...) {
+	va_list args;
+
+	va_start(args, fmt);
+	get_log_ring().record(level, fmt, args);
+	va_end(args);
+}
+
+void thd_log_ring_flush() {
+	get_log_ring().drain();
+}
+
+static void thd_log_ring_crash_handler(int sig) {
+	static const char header[] = "thermald crashed, recent log records:\n";
+	int fd;
+
+	if (write(STDERR_FILENO, header, sizeof(header) - 1) > 0)
+		get_log_ring().dump(STDERR_FILENO);
+
+	fd = open(crash_dump_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			0600);
+	if (fd >= 0) {
+		get_log_ring().dump(fd);
+		close(fd);
+	}
+
+	// SA_RESETHAND restored the default action
+	raise(sig);
+}
+
+// Before daemon() so that early records are flushed on exit
+void thd_log_ring_init(int level_mask, thd_log_writer_t writer) {
+	static const int crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL,
+			SIGABRT };
+	struct sigaction action;
+
+	get_log_ring().set_level_mask(level_mask);
+	get_log_ring().set_writer(writer);
+	snprintf(crash_dump_file, sizeof(crash_dump_file), "%s",
+			csys_fs::map_path(TDRUNDIR "/thd_log_ring.dump").c_str());
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = thd_log_ring_crash_handler;
+	action.sa_flags = SA_RESETHAND | SA_NODEFER;
+	sigemptyset(&action.sa_mask);
+	for (unsigned int i = 0; i < sizeof(crash_signals) / sizeof(int); ++i)
+		sigaction(crash_signals[i], &action, nullptr);
+
+	atexit(thd_log_ring_flush);
+}
+
+// After daemon(), the drainer thread doesn't survive fork()
+int thd_log_ring_start() {
+	return get_log_ring().start_drainer();
+}
@@ -0,0 +1,111 @@
+/*
+ * thd_log_ring.h: deferred logging ring interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_LOG_RING_H_
+#define THD_LOG_RING_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include "thermald.h"
+
+// Info and debug logs are stored in binary form: the format string pointer
+// and the raw arguments. Formatting happens in a background thread, woken
+// only when a record of an enabled level is added. The ring keeps the most
+// recent records, so it is dumped as a flight recorder when the daemon
+// crashes. Debug records are skipped unless the debug level is enabled,
+// info records are always kept for the crash dump.
+class cthd_log_ring {
+private:
+	static constexpr unsigned int ring_size = 2048; // Power of 2
+	static constexpr int max_args = 12;
+	static constexpr int str_buf_size = 192;
+
+	typedef enum : uint8_t {
+		ARG_INT, ARG_LONG, ARG_LONG_LONG, ARG_DOUBLE, ARG_PTR, ARG_STR
+	} arg_type_t;
+
+	typedef struct {
+		long long time_ns;
+		int level;
+		const char *fmt;
+		uint8_t nargs;
+		bool truncated;
+		arg_type_t types[max_args];
+		union {
+			long long i;
+			double d;
+			const void *p;
+			uint16_t str_offset;
+		} args[max_args];
+		char str_buf[str_buf_size];
+	} log_record_t;
+
+	typedef struct {
+		// 2 * pos + 1 while written, 2 * pos + 2 when complete
+		std::atomic<uint64_t> seq;
+		log_record_t rec;
+	} log_slot_t;
+
+	typedef enum {
+		READ_OK, READ_PENDING, READ_LOST
+	} read_status_t;
+
+	log_slot_t ring[ring_size];
+	std::atomic<uint64_t> head;
+	std::mutex drain_lock;
+	uint64_t drain_pos;
+	std::atomic<int> level_mask;
+	thd_log_writer_t writer;
+	std::atomic<bool> drainer_running;
+	pthread_t drainer;
+	// Set by producers of enabled records, cleared by the drainer
+	std::atomic<bool> drain_pending;
+	std::mutex wake_lock;
+	std::condition_variable wake_cond;
+
+	static void *drainer_thread(void *arg);
+	static int format_record(const log_record_t &rec, char *buf, int size);
+	read_status_t read_record(uint64_t pos, log_record_t *rec);
+	void write_out(int fd, const log_record_t &rec);
+
+public:
+	cthd_log_ring();
+
+	void record(int level, const char *fmt, va_list args);
+	void set_level_mask(int mask) {
+		level_mask.store(mask, std::memory_order_relaxed);
+	}
+	void set_writer(thd_log_writer_t _writer) {
+		writer = _writer;
+	}
+	int start_drainer();
+	void drain();
+	void dump(int fd);
+};
+
+#endif /* THD_LOG_RING_H_ */
@@ -0,0 +1,306 @@
+/*
+ * thd_metrics.cpp: metrics exporter implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Metrics for fleet dashboards, enabled with --metrics-interval. The file is
+ * in the Prometheus text format read by the node_exporter textfile collector
+ * and is replaced by rename, so the collector never sees a partial file.
+ * Values come from the engine snapshot, time at each cooling device state
+ * is accounted on every published snapshot.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include "thd_common.h"
+#include "thd_metrics.h"
+#include "thd_trip_point.h"
+
+// Upper bounds of the tick latency histogram buckets in usec
+static const long long tick_bounds[] = { 100, 250, 500, 1000, 2500, 5000,
+		10000, 25000, 50000, 100000, 250000 };
+static constexpr int tick_bound_count = sizeof(tick_bounds)
+		/ sizeof(tick_bounds[0]);
+// Last state of a cdev which was not in the previous snapshot
+static const int unknown_state = INT_MIN;
+
+cthd_metrics::cthd_metrics() :
+		last_time(0) {
+}
+
+// Exact states for small ranges, else the lowest state of the bucket
+int cthd_metrics::state_bucket(const thd_snapshot_cdev_t &cdev, int state) {
+	long long low = std::min(cdev.min_state, cdev.max_state);
+	long long high = std::max(cdev.min_state, cdev.max_state);
+	long long range = high - low;
+
+	if (range <= max_state_buckets || state < low || state > high)
+		return state;
+
+	long long bucket = (state - low) * max_state_buckets / range;
+	if (bucket >= max_state_buckets)
+		bucket = max_state_buckets - 1;
+
+	return (int) (low + (bucket * range + max_state_buckets - 1)
+			/ max_state_buckets);
+}
+
+void cthd_metrics::record(const cthd_engine_snapshot &snap) {
+	if (layout != snap.layout) {
+		std::unordered_map<int, int> states;
+
+		layout = snap.layout;
+		layout_state_time.clear();
+		layout_last_state.clear();
+		for (const thd_snapshot_cdev_t &cdev : layout->cdevs) {
+			layout_state_time.push_back(&state_time[cdev.index]);
+			auto it = last_state.find(cdev.index);
+			int &state = states[cdev.index];
+			state = it != last_state.end() ? it->second : unknown_state;
+			layout_last_state.push_back(&state);
+		}
+		last_state.swap(states);
+	}
+
+	// Snapshots of user changes may come with an older tick time
+	long long elapsed = last_time ? snap.time - last_time : 0;
+	if (elapsed > 0 || !last_time)
+		last_time = snap.time;
+
+	// The time since the last snapshot was spent in the states before it
+	for (unsigned int i = 0; i < layout_last_state.size(); ++i) {
+		int &state = *layout_last_state[i];
+		if (elapsed > 0 && state != unknown_state)
+			(*layout_state_time[i])[state_bucket(layout->cdevs[i], state)] +=
+					elapsed;
+		state = snap.cdev_states[i];
+	}
+}
+
+static std::string metrics_escape(const std::string &value) {
+	std::string out;
+
+	for (char c : value) {
+		if (c == '\\' || c == '"')
+			out += '\\';
+		if (c == '\n')
+			out += "\\n";
+		else
+			out += c;
+	}
+
+	return out;
+}
+
+static void metrics_header(std::ostringstream &out, const char *name,
+		const char *type, const char *help) {
+	out << "# HELP " << name << " " << help << "\n";
+	out << "# TYPE " << name << " " << type << "\n";
+}
+
+static const char *metrics_trip_type(int type) {
+	switch (type) {
+	case CRITICAL:
+		return "critical";
+	case HOT:
+		return "hot";
+	case MAX:
+		return "max";
+	case PASSIVE:
+		return "passive";
+	case ACTIVE:
+		return "active";
+	case POLLING:
+		return "polling";
+	default:
+		return "invalid";
+	}
+}
+
+int cthd_metrics::write(const std::string &path,
+		const thd_metrics_sample_t &sample, cthd_engine_stats &stats,
+		cthd_rapl_power_meter &rapl_power_meter) {
+	const cthd_engine_snapshot &snap = *sample.snap;
+	const cthd_snapshot_layout &snap_layout = *snap.layout;
+	std::ostringstream out;
+	char value[32];
+
+	metrics_header(out, "thermald_sensor_temperature_celsius", "gauge",
+			"Last sampled sensor temperature.");
+	for (unsigned int i = 0; i < snap_layout.sensors.size(); ++i) {
+		if (!snap.sensor_times[i])
+			continue;
+		snprintf(value, sizeof(value), "%.3f", snap.sensor_temps[i] / 1000.0);
+		out << "thermald_sensor_temperature_celsius{sensor=\""
+				<< metrics_escape(snap_layout.sensors[i].type) << "\",index=\""
+				<< snap_layout.sensors[i].index << "\"} " << value << "\n";
+	}
+
+	metrics_header(out, "thermald_sensor_sysfs_read_errors_total", "counter",
+			"Failed sysfs temperature reads.");
+	for (unsigned int i = 0; i < sample.sensor_read_errors.size(); ++i)
+		out << "thermald_sensor_sysfs_read_errors_total{sensor=\""
+				<< metrics_escape(snap_layout.sensors[i].type) << "\",index=\""
+				<< snap_layout.sensors[i].index << "\"} "
+				<< sample.sensor_read_errors[i] << "\n";
+
+	metrics_header(out, "thermald_zone_temperature_celsius", "gauge",
+			"Zone temperature of the last evaluation.");
+	for (unsigned int i = 0; i < snap_layout.zones.size(); ++i) {
+		snprintf(value, sizeof(value), "%.3f", snap.zone_temps[i] / 1000.0);
+		out << "thermald_zone_temperature_celsius{zone=\""
+				<< metrics_escape(snap_layout.zones[i].type) << "\"} " << value
+				<< "\n";
+	}
+
+	metrics_header(out, "thermald_zone_active", "gauge",
+			"1 when thermald controls the zone.");
+	for (unsigned int i = 0; i < snap_layout.zones.size(); ++i)
+		out << "thermald_zone_active{zone=\""
+				<< metrics_escape(snap_layout.zones[i].type) << "\"} "
+				<< (snap.zone_active[i] ? 1 : 0) << "\n";
+
+	metrics_header(out, "thermald_trip_crossings_total", "counter",
+			"Times the temperature crossed the trip, in either direction.");
+	for (const thd_snapshot_zone_t &zone : snap_layout.zones) {
+		for (unsigned int j = 0; j < zone.trips.size(); ++j)
+			out << "thermald_trip_crossings_total{zone=\""
+					<< metrics_escape(zone.type) << "\",trip=\"" << j
+					<< "\",type=\"" << metrics_trip_type(zone.trips[j].type)
+					<< "\"} " << snap.trip_crossings[zone.first_trip + j]
+					<< "\n";
+	}
+
+	metrics_header(out, "thermald_trip_active", "gauge",
+			"1 while the trip is crossed and its cooling devices are engaged.");
+	for (const thd_snapshot_zone_t &zone : snap_layout.zones) {
+		for (unsigned int j = 0; j < zone.trips.size(); ++j)
+			out << "thermald_trip_active{zone=\"" << metrics_escape(zone.type)
+					<< "\",trip=\"" << j << "\",type=\""
+					<< metrics_trip_type(zone.trips[j].type) << "\"} "
+					<< (snap.trip_on[zone.first_trip + j] ? 1 : 0) << "\n";
+	}
+
+	metrics_header(out, "thermald_cooling_device_state", "gauge",
+			"Current cooling device state.");
+	for (unsigned int i = 0; i < snap_layout.cdevs.size(); ++i)
+		out << "thermald_cooling_device_state{cdev=\""
+				<< metrics_escape(snap_layout.cdevs[i].type) << "\",index=\""
+				<< snap_layout.cdevs[i].index << "\"} " << snap.cdev_states[i]
+				<< "\n";
+
+	metrics_header(out, "thermald_cooling_device_min_state", "gauge",
+			"State without cooling.");
+	for (const thd_snapshot_cdev_t &cdev : snap_layout.cdevs)
+		out << "thermald_cooling_device_min_state{cdev=\""
+				<< metrics_escape(cdev.type) << "\",index=\"" << cdev.index
+				<< "\"} " << cdev.min_state << "\n";
+
+	metrics_header(out, "thermald_cooling_device_max_state", "gauge",
+			"State of maximum cooling.");
+	for (const thd_snapshot_cdev_t &cdev : snap_layout.cdevs)
+		out << "thermald_cooling_device_max_state{cdev=\""
+				<< metrics_escape(cdev.type) << "\",index=\"" << cdev.index
+				<< "\"} " << cdev.max_state << "\n";
+
+	metrics_header(out, "thermald_cooling_device_state_seconds_total",
+			"counter", "Time at each cooling device state. Large state "
+					"ranges are split in 32 buckets, labeled by the lowest "
+					"state of the bucket.");
+	for (const thd_snapshot_cdev_t &cdev : snap_layout.cdevs) {
+		auto it = sample.state_time.find(cdev.index);
+		if (it == sample.state_time.end())
+			continue;
+		for (const auto &state : it->second) {
+			snprintf(value, sizeof(value), "%.3f", state.second / 1000.0);
+			out << "thermald_cooling_device_state_seconds_total{cdev=\""
+					<< metrics_escape(cdev.type) << "\",index=\"" << cdev.index
+					<< "\",state=\"" << state.first << "\"} " << value << "\n";
+		}
+	}
+
+	metrics_header(out, "thermald_cooling_device_sysfs_write_errors_total",
+			"counter", "Failed cooling device state writes.");
+	for (unsigned int i = 0; i < sample.cdev_write_errors.size(); ++i)
+		out << "thermald_cooling_device_sysfs_write_errors_total{cdev=\""
+				<< metrics_escape(snap_layout.cdevs[i].type) << "\",index=\""
+				<< snap_layout.cdevs[i].index << "\"} "
+				<< sample.cdev_write_errors[i] << "\n";
+
+	cthd_latency_histogram &tick = stats.get_histogram(STAT_TICK);
+	unsigned long counts[tick_bound_count];
+	unsigned long count;
+
+	tick.cumulative_counts(tick_bounds, tick_bound_count, counts, &count);
+	metrics_header(out, "thermald_engine_tick_duration_seconds", "histogram",
+			"Engine loop iteration time after a wakeup.");
+	for (int i = 0; i < tick_bound_count; ++i) {
+		snprintf(value, sizeof(value), "%g", tick_bounds[i] / 1000000.0);
+		out << "thermald_engine_tick_duration_seconds_bucket{le=\"" << value
+				<< "\"} " << counts[i] << "\n";
+	}
+	out << "thermald_engine_tick_duration_seconds_bucket{le=\"+Inf\"} "
+			<< count << "\n";
+	snprintf(value, sizeof(value), "%.6f", tick.get_sum() / 1000000.0);
+	out << "thermald_engine_tick_duration_seconds_sum " << value << "\n";
+	out << "thermald_engine_tick_duration_seconds_count " << count << "\n";
+
+	static const struct {
+		domain_type type;
+		const char *name;
+	} rapl_domains[] = { { PACKAGE, "package" }, { DRAM, "dram" } };
+
+	metrics_header(out, "thermald_rapl_power_watts", "gauge",
+			"RAPL power from the energy counters.");
+	for (const auto &domain : rapl_domains) {
+		rapl_power_snapshot_t rapl;
+
+		if (!rapl_power_meter.rapl_get_power_snapshot(domain.type, &rapl))
+			continue;
+		snprintf(value, sizeof(value), "%.3f", rapl.power / 1000000.0);
+		out << "thermald_rapl_power_watts{domain=\"" << domain.name << "\"} "
+				<< value << "\n";
+	}
+
+	std::string tmp_path = path + ".tmp";
+	std::string text = out.str();
+	int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			0644);
+	if (fd < 0) {
+		thd_log_warn("Can't create metrics file %s: %s\n", tmp_path.c_str(),
+				strerror(errno));
+		return THD_ERROR;
+	}
+
+	ssize_t ret = ::write(fd, text.c_str(), text.size());
+	::close(fd);
+	if (ret != (ssize_t) text.size()
+			|| rename(tmp_path.c_str(), path.c_str())) {
+		thd_log_warn("Can't write metrics file %s\n", path.c_str());
+		unlink(tmp_path.c_str());
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
@@ -0,0 +1,77 @@
+/*
+ * thd_metrics.h: metrics exporter interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_METRICS_H_
+#define THD_METRICS_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "thd_engine_snapshot.h"
+#include "thd_engine_stats.h"
+#include "thd_rapl_power_meter.h"
+
+// Engine counters collected under the engine lock, written without it
+typedef struct {
+	std::shared_ptr<const cthd_engine_snapshot> snap;
+	// In snapshot layout order
+	std::vector<unsigned long> sensor_read_errors;
+	std::vector<unsigned long> cdev_write_errors;
+	// Per cdev index, msec spent at each state
+	std::unordered_map<int, std::map<int, long long>> state_time;
+} thd_metrics_sample_t;
+
+// Prometheus text format file for the node_exporter textfile collector
+class cthd_metrics {
+private:
+	// Cdevs with a larger state range, like RAPL power limits, have their
+	// state time accounted in this many buckets of the range
+	static constexpr int max_state_buckets = 32;
+
+	long long last_time;
+	std::shared_ptr<const cthd_snapshot_layout> layout;
+	std::unordered_map<int, std::map<int, long long>> state_time;
+	// state_time of each cdev in layout order
+	std::vector<std::map<int, long long> *> layout_state_time;
+	// Cdev states of the last snapshot, until the next one
+	std::unordered_map<int, int> last_state;
+	std::vector<int *> layout_last_state;
+
+	static int state_bucket(const thd_snapshot_cdev_t &cdev, int state);
+
+public:
+	cthd_metrics();
+
+	// Account the cdev states of a snapshot, called with the engine lock held
+	void record(const cthd_engine_snapshot &snap);
+	std::unordered_map<int, std::map<int, long long>> &get_state_time() {
+		return state_time;
+	}
+	int write(const std::string &path, const thd_metrics_sample_t &sample,
+			cthd_engine_stats &stats, cthd_rapl_power_meter &rapl_power_meter);
+};
+
+#endif /* THD_METRICS_H_ */
@@ -0,0 +1,111 @@
+/*
+ * thd_msg_queue.cpp: engine message queue implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Bounded multi producer queue based on per cell sequence numbers. A
+ * producer claims a slot by advancing enqueue_pos and publishes it by
+ * storing the next sequence, so the consumer never sees a partial message.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "thd_common.h"
+#include "thd_msg_queue.h"
+
+cthd_msg_queue::cthd_msg_queue() :
+		enqueue_pos(0), dequeue_pos(0), event_fd(-1) {
+	for (size_t i = 0; i < queue_size; ++i)
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+cthd_msg_queue::~cthd_msg_queue() {
+	if (event_fd >= 0)
+		close(event_fd);
+}
+
+int cthd_msg_queue::open() {
+	event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (event_fd < 0) {
+		thd_log_error("eventfd creation failed: %s\n", strerror(errno));
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
+bool cthd_msg_queue::push(const message_capsul_t &msg) {
+	msg_cell_t *cell;
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+	for (;;) {
+		cell = &cells[pos & (queue_size - 1)];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+		if (diff == 0) {
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+					std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->msg = msg;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+
+	// No doorbell before open(), queued messages wait for the first drain
+	uint64_t one = 1;
+	if (event_fd >= 0 && write(event_fd, &one, sizeof(one)) < 0
+			&& errno != EAGAIN)
+		thd_log_warn("Write to message doorbell failed\n");
+
+	return true;
+}
+
+bool cthd_msg_queue::pop(message_capsul_t *msg) {
+	msg_cell_t *cell = &cells[dequeue_pos & (queue_size - 1)];
+	size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+	if (seq != dequeue_pos + 1)
+		return false;
+
+	*msg = cell->msg;
+	cell->sequence.store(dequeue_pos + queue_size, std::memory_order_release);
+	++dequeue_pos;
+
+	return true;
+}
+
+// Called before draining, so a push racing with the drain rings again
+void cthd_msg_queue::clear_doorbell() {
+	uint64_t count;
+
+	if (event_fd >= 0 && read(event_fd, &count, sizeof(count)) < 0
+			&& errno != EAGAIN)
+		thd_log_debug("read on message doorbell failed\n");
+}
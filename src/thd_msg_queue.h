@@ -0,0 +1,88 @@
+/*
+ * thd_msg_queue.h: engine message queue interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_MSG_QUEUE_H_
+#define THD_MSG_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Payload is small: a sensor id or a thermal_zone_notify_t
+#define MAX_MSG_SIZE 		4
+
+typedef enum : uint8_t {
+	WAKEUP,
+	TERMINATE,
+	PREF_CHANGED,
+	THERMAL_ZONE_NOTIFY,
+	RELOAD_ZONES,
+	POLL_ENABLE,
+	POLL_DISABLE,
+	FAST_POLL_ENABLE,
+	FAST_POLL_DISABLE,
+	SENSOR_CHANGED,
+} message_name_t;
+
+typedef struct {
+	message_name_t msg_id;
+	int msg_size;
+	unsigned long msg[MAX_MSG_SIZE];
+} message_capsul_t;
+
+// Bounded lock free queue with many producers (D-Bus, sensors, engine
+// itself) and the engine thread as the only consumer. An eventfd is used
+// as doorbell, so the engine can wait for messages in poll().
+class cthd_msg_queue {
+private:
+	static constexpr size_t queue_size = 256; // Power of 2
+
+	typedef struct {
+		std::atomic<size_t> sequence;
+		message_capsul_t msg;
+	} msg_cell_t;
+
+	msg_cell_t cells[queue_size];
+	std::atomic<size_t> enqueue_pos;
+	size_t dequeue_pos;
+	int event_fd;
+
+public:
+	cthd_msg_queue();
+	~cthd_msg_queue();
+	cthd_msg_queue(const cthd_msg_queue &) = delete;
+	cthd_msg_queue &operator=(const cthd_msg_queue &) = delete;
+
+	int open();
+	int get_fd() {
+		return event_fd;
+	}
+	// Any thread, returns false when the queue is full
+	bool push(const message_capsul_t &msg);
+	// Engine thread only
+	bool pop(message_capsul_t *msg);
+	void clear_doorbell();
+};
+
+#endif /* THD_MSG_QUEUE_H_ */
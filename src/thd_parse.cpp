@@ -382,6 +382,10 @@ int cthd_parse::parse_new_zone(xmlNode * a_node, xmlDoc *doc,
 			} else if (!thd_strcasecmp_n((const char*) cur_node->name, "Type")) {
 				info_ptr->type.assign((const char*) tmp_value);
 				string_trim(info_ptr->type);
+			} else if (!thd_strcasecmp_n((const char*) cur_node->name,
+					"UeventDebounce")) {
+				if (tmp_value)
+					info_ptr->uevent_debounce = atoi(tmp_value);
 			}
 			if (tmp_value)
 				xmlFree(tmp_value);
@@ -495,6 +499,7 @@ int cthd_parse::parse_thermal_zones(xmlNode * a_node, xmlDoc *doc,
 			DEBUG_PARSER_PRINT("node type: Element, name: %s value: %s\n", cur_node->name, xmlNodeListGetString(doc, cur_node->xmlChildrenNode, 1));
 			if (!thd_strcasecmp_n((const char*) cur_node->name, "ThermalZone")) {
 				zone.trip_pts.clear();
+				zone.uevent_debounce = 0;
 				parse_new_zone(cur_node->children, doc, &zone);
 				info_ptr->zones.push_back(zone);
 			}
@@ -905,6 +910,9 @@ void cthd_parse::dump_thermal_conf() {
 			thd_log_info("\tZone %u\n", j);
 			thd_log_info("\t Name: %s\n",
 					thermal_info_list[i].zones[j].type.c_str());
+			if (thermal_info_list[i].zones[j].uevent_debounce)
+				thd_log_info("\t UeventDebounce: %d\n",
+						thermal_info_list[i].zones[j].uevent_debounce);
 			for (unsigned int k = 0;
 					k < thermal_info_list[i].zones[j].trip_pts.size(); ++k) {
 				thd_log_info("\t\t Trip Point %u\n", k);
@@ -985,7 +993,8 @@ int cthd_parse::get_polling_interval() {
 
 bool cthd_parse::match_product_sku(int index) {
 	std::string line;
-	std::ifstream product_sku("/sys/class/dmi/id/product_sku");
+	std::ifstream product_sku(
+			csys_fs::map_path("/sys/class/dmi/id/product_sku"));
 
 	if (product_sku.is_open() && getline(product_sku, line)) {
 		if (!thermal_info_list[index].product_sku.size())
@@ -1012,7 +1021,8 @@ bool cthd_parse::platform_matched() {
 
 	std::string line;
 
-	std::ifstream product_uuid("/sys/class/dmi/id/product_uuid");
+	std::ifstream product_uuid(
+			csys_fs::map_path("/sys/class/dmi/id/product_uuid"));
 
 	if (product_uuid.is_open() && getline(product_uuid, line)) {
 		for (unsigned int i = 0; i < thermal_info_list.size(); ++i) {
@@ -1034,7 +1044,8 @@ bool cthd_parse::platform_matched() {
 		}
 	}
 
-	std::ifstream product_name("/sys/class/dmi/id/product_name");
+	std::ifstream product_name(
+			csys_fs::map_path("/sys/class/dmi/id/product_name"));
 
 	if (product_name.is_open() && getline(product_name, line)) {
 		for (unsigned int i = 0; i < thermal_info_list.size(); ++i) {
@@ -113,6 +113,7 @@ typedef struct {
 
 typedef struct {
 	std::string type;
+	int uevent_debounce; // msec, 0 for default
 	std::vector<trip_point_t> trip_pts;
 } thermal_zone_t;
 
@@ -22,6 +22,7 @@
  *
  */
 #include "thd_pid.h"
+#include "thd_util.h"
 
 cthd_pid::cthd_pid() {
 	kp = 0.0005;
@@ -37,8 +38,7 @@ int cthd_pid::pid_output(unsigned int curr_temp, int initial_value) {
 	double d_err = 0;
 	int error = curr_temp - target_temp;
 
-	time_t now;
-	time(&now);
+	long long now = thd_get_monotonic_msec();
 	if (last_time == 0) {
 		last_time = now;
 
@@ -50,11 +50,12 @@ int cthd_pid::pid_output(unsigned int curr_temp, int initial_value) {
 		else
 			err_sum = 0;
 	}
-	time_t timeChange = (now - last_time);
+	// Gains are per second, use sub second resolution for the interval
+	double timeChange = (now - last_time) / 1000.0;
 
 	thd_log_debug("pid_output error %d %g:%g\n", error, kp, kp * error);
 	err_sum += (error * timeChange);
-	if (timeChange)
+	if (timeChange > 0)
 		d_err = (error - last_err) / timeChange;
 	else
 		d_err = 0.0;
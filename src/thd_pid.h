@@ -37,7 +37,7 @@ class cthd_pid {
 
 private:
 	double err_sum, last_err;
-	time_t last_time;
+	long long last_time; // Monotonic msec
 	unsigned int target_temp;
 
 public:
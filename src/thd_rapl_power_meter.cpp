@@ -23,33 +23,21 @@
  */
 
 #include "thd_rapl_power_meter.h"
+#include "thd_engine.h"
 #include <dirent.h>
 #include <fnmatch.h>
 #include <time.h>
 #include "thd_util.h"
 
-static void *rapl_periodic_callback(void *data) {
-	cthd_rapl_power_meter *rapl_cl = (cthd_rapl_power_meter*) data;
-
-	for (;;) {
-		if (!rapl_cl->rapl_energy_loop())
-			break;
-		sleep(rapl_cl->rapl_callback_timeout);
-	}
-
-	return nullptr;
-}
-
 cthd_rapl_power_meter::cthd_rapl_power_meter(unsigned int mask) :
 		rapl_present(true), rapl_sysfs("/sys/class/powercap/intel-rapl/"), domain_list(
-				0), last_time(0), poll_thread(0), measure_mask(mask), enable_measurement(
-				false) {
-	thd_attr = pthread_attr_t();
+				0), last_time_ns(0), measure_mask(mask), enable_measurement(
+				false), timer_service(nullptr), timer_id(-1), snapshot_seq(0) {
+	memset(published, 0, sizeof(published));
 
 	if (rapl_sysfs.exists()) {
 		thd_log_debug("RAPL sysfs present\n");
 		rapl_present = true;
-		last_time = time(nullptr);
 		rapl_read_domains(rapl_sysfs.get_base_path().c_str());
 	} else {
 		thd_log_warn("NO RAPL sysfs present\n");
@@ -65,22 +53,23 @@ void cthd_rapl_power_meter::rapl_read_domains(const char *dir_name) {
 		DIR *dir;
 		struct dirent *dir_entry;
 		thd_log_debug("RAPL base path %s\n", dir_name);
-		if ((dir = opendir(dir_name)) != nullptr) {
+		if ((dir = opendir(csys_fs::map_path(dir_name).c_str())) != nullptr) {
 			while ((dir_entry = readdir(dir)) != nullptr) {
 				std::string buffer;
 				std::ostringstream path;
 				int status;
 				rapl_domain_t domain;
 
-				domain.half_way = 0;
 				domain.energy_counter = 0;
-				domain.energy_cumulative_counter = 0;
+				domain.energy_total = 0;
+				domain.last_read_ns = 0;
 				domain.max_energy_range = 0;
-				domain.max_energy_range_threshold = 0;
 				domain.power = 0;
 				domain.max_power = 0;
 				domain.min_power = 0;
 				domain.type = INVALID;
+				domain.sample_head = 0;
+				domain.sample_count = 0;
 
 				if (!thd_strcmp_n(dir_entry->d_name, ".")
 						|| !thd_strcmp_n(dir_entry->d_name, ".."))
@@ -111,6 +100,7 @@ void cthd_rapl_power_meter::rapl_read_domains(const char *dir_name) {
 					domain.name = std::move(buffer);
 					domain.path = std::string(dir_name)
 							+ std::string(dir_entry->d_name);
+					rapl_open_domain_attrs(domain);
 					domain_list.push_back(std::move(domain));
 					++count;
 				}
@@ -125,100 +115,246 @@ void cthd_rapl_power_meter::rapl_read_domains(const char *dir_name) {
 	thd_log_info("RAPL domain count %d\n", count);
 }
 
-void cthd_rapl_power_meter::rapl_enable_periodic_timer() {
-	pthread_attr_init(&thd_attr);
-	pthread_attr_setdetachstate(&thd_attr, PTHREAD_CREATE_DETACHED);
-	pthread_create(&poll_thread, &thd_attr, rapl_periodic_callback,
-			(void*) this);
+void cthd_rapl_power_meter::rapl_open_domain_attrs(rapl_domain_t &domain) {
+	domain.energy_attr.reset(new csys_fs_attr());
+	domain.energy_attr->open(domain.path + "/energy_uj");
+
+	domain.max_energy_range_attr.reset(new csys_fs_attr());
+	domain.max_energy_range_attr->open(domain.path + "/max_energy_range_uj");
+
+	for (int i = 0; i < 2; ++i) {
+		std::ostringstream path;
+
+		path << domain.path << "/constraint_" << i << "_max_power_uw";
+		domain.constraint_max_power_attr[i].reset(new csys_fs_attr());
+		// Not all domains have constraint 1
+		if (!access(csys_fs::map_path(path.str()).c_str(), F_OK))
+			domain.constraint_max_power_attr[i]->open(path.str());
+	}
+}
+
+// Keep reading the energy counters while the engine sleeps for long, so
+// that counter wraparounds are not missed and averages have history
+void cthd_rapl_power_meter::rapl_enable_periodic_timer(
+		cthd_timer_service &service) {
+	if (timer_service)
+		return;
+
+	timer_service = &service;
+	timer_id = service.add_timer(enable_measurement ? 0 : -1, rapl_timer_slack,
+			[this](long long deadline, long long now) {
+				if (!rapl_energy_loop())
+					return -1LL;
+				return cthd_timer_service::next_period(deadline, now,
+						rapl_callback_timeout * 1000LL);
+			});
+}
+
+void cthd_rapl_power_meter::rapl_start_measure_power() {
+	if (enable_measurement)
+		return;
+
+	enable_measurement = true;
+	if (timer_service)
+		timer_service->set_deadline(timer_id, 0);
+}
+
+void cthd_rapl_power_meter::rapl_store_sample(rapl_domain_t &domain,
+		long long time_ns) {
+	if (domain.sample_count) {
+		unsigned int last = (domain.sample_head + RAPL_POWER_SAMPLES - 1)
+				% RAPL_POWER_SAMPLES;
+		if (time_ns - domain.samples[last].time_ns < rapl_sample_interval_ns)
+			return;
+	}
+
+	domain.samples[domain.sample_head].time_ns = time_ns;
+	domain.samples[domain.sample_head].energy = domain.energy_total;
+	domain.sample_head = (domain.sample_head + 1) % RAPL_POWER_SAMPLES;
+	if (domain.sample_count < RAPL_POWER_SAMPLES)
+		++domain.sample_count;
+}
+
+// Average power in uW from the last read back to the newest stored sample,
+// which is at least window_ns old. With less history, the oldest is used.
+unsigned int cthd_rapl_power_meter::rapl_window_power(rapl_domain_t &domain,
+		long long window_ns) {
+	rapl_power_sample_t *ref = nullptr;
+
+	for (unsigned int i = 1; i <= domain.sample_count; ++i) {
+		unsigned int index = (domain.sample_head + RAPL_POWER_SAMPLES - i)
+				% RAPL_POWER_SAMPLES;
+
+		ref = &domain.samples[index];
+		if (domain.last_read_ns - ref->time_ns >= window_ns)
+			break;
+	}
+
+	if (!ref || domain.last_read_ns <= ref->time_ns)
+		return domain.power;
+
+	unsigned long long delta_us = (domain.last_read_ns - ref->time_ns) / 1000;
+	if (!delta_us)
+		return domain.power;
+
+	return (domain.energy_total - ref->energy) * 1000000ULL / delta_us;
 }
 
 bool cthd_rapl_power_meter::rapl_energy_loop() {
-	csys_fs sys_fs;
 	int status;
-	unsigned long long counter;
-	unsigned long long diff;
-	time_t curr_time;
+	long long curr_time_ns;
 
 	if (!enable_measurement)
 		return false;
 
-	curr_time = time(nullptr);
-	if ((curr_time - last_time) <= 0)
+	curr_time_ns = thd_get_monotonic_nsec();
+	if (last_time_ns && (curr_time_ns - last_time_ns) < rapl_min_read_interval_ns)
 		return true;
+
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
+		rapl_domain_t &domain = domain_list[i];
 		unsigned long energy_uj;
-		std::string path;
 
-		if (!domain_list[i].max_energy_range) {
-			std::string _path;
+		if (!domain.max_energy_range && domain.max_energy_range_attr->is_open()) {
 			unsigned long _value;
-			_path = domain_list[i].path + "/" + "max_energy_range_uj";
-			status = sys_fs.read(_path, &_value);
-			if (status >= 0)
-				domain_list[i].max_energy_range = _value / 1000;
-			domain_list[i].max_energy_range_threshold =
-					domain_list[i].max_energy_range / 2;
+			status = domain.max_energy_range_attr->read(&_value);
+			if (status > 0)
+				domain.max_energy_range = _value;
 		}
 
-		path = domain_list[i].path + "/" + "energy_uj";
-		status = sys_fs.read(path, &energy_uj);
-		if (status >= 0) {
-			counter = domain_list[i].energy_counter;
-			domain_list[i].energy_counter = energy_uj / 1000; // To milli Js
+		if (!domain.energy_attr->is_open())
+			continue;
+
+		// Read time close to the counter read to get a precise interval
+		long long read_ns = thd_get_monotonic_nsec();
+		status = domain.energy_attr->read(&energy_uj);
+		if (status <= 0)
+			continue;
+
+		if (!domain.last_read_ns) {
+			domain.energy_counter = energy_uj;
+			domain.energy_total = energy_uj;
+			domain.last_read_ns = read_ns;
+			rapl_store_sample(domain, read_ns);
+			continue;
+		}
 
+		unsigned long long diff;
+		if (energy_uj >= domain.energy_counter) {
+			diff = energy_uj - domain.energy_counter;
+		} else if (domain.max_energy_range) {
+			// Counter wraps at max_energy_range_uj
+			diff = domain.max_energy_range - domain.energy_counter + energy_uj;
+		} else {
+			// Can't unwrap without range, rebase on the next read
 			diff = 0;
-			if (domain_list[i].half_way
-					&& domain_list[i].energy_counter
-							< domain_list[i].max_energy_range_threshold) {
-				// wrap around
-				domain_list[i].energy_cumulative_counter +=
-						domain_list[i].max_energy_range;
-				diff = domain_list[i].max_energy_range - counter;
-				counter = 0;
-				domain_list[i].half_way = 0;
-
-			} else if (domain_list[i].energy_counter
-					> domain_list[i].max_energy_range_threshold)
-				domain_list[i].half_way = 1;
-
-			if (counter)
-				domain_list[i].power = (domain_list[i].energy_counter - counter
-						+ diff) / (curr_time - last_time);
-			if (domain_list[i].power > domain_list[i].max_power)
-				domain_list[i].max_power = domain_list[i].power;
-
-			if (domain_list[i].min_power == 0)
-				domain_list[i].min_power = domain_list[i].power;
-			else if (domain_list[i].power < domain_list[i].min_power)
-				domain_list[i].min_power = domain_list[i].power;
-
-			thd_log_debug(" energy %d:%lld:%lld mj: %u mw\n",
-					domain_list[i].type,
-					domain_list[i].energy_cumulative_counter,
-					domain_list[i].energy_counter
-							+ domain_list[i].energy_cumulative_counter,
-					domain_list[i].power);
-
 		}
+
+		unsigned long long delta_us = (read_ns - domain.last_read_ns) / 1000;
+
+		domain.energy_counter = energy_uj;
+		domain.energy_total += diff;
+		domain.last_read_ns = read_ns;
+		if (delta_us)
+			domain.power = diff * 1000000ULL / delta_us;
+
+		if (domain.power > domain.max_power)
+			domain.max_power = domain.power;
+
+		if (domain.min_power == 0)
+			domain.min_power = domain.power;
+		else if (domain.power < domain.min_power)
+			domain.min_power = domain.power;
+
+		rapl_store_sample(domain, read_ns);
+		thd_engine->get_trace().record(TRACE_RAPL_POWER, domain.type, 0,
+				domain.power);
+
+		thd_log_debug(" energy %d:%llu uj: %u uw\n", domain.type,
+				domain.energy_total, domain.power);
 	}
-	last_time = curr_time;
+	last_time_ns = curr_time_ns;
+	rapl_publish_snapshot();
 
 	return true;
 }
 
+static int rapl_domain_index(domain_type type) {
+	switch (type) {
+	case PACKAGE:
+		return 0;
+	case DRAM:
+		return 1;
+	case CORE:
+		return 2;
+	case UNCORE:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+// Only the engine thread reads RAPL counters, so there is a single writer
+void cthd_rapl_power_meter::rapl_publish_snapshot() {
+	rapl_power_snapshot_t snapshot[RAPL_DOMAIN_TYPES];
+
+	memset(snapshot, 0, sizeof(snapshot));
+	for (unsigned int i = 0; i < domain_list.size(); ++i) {
+		rapl_domain_t &domain = domain_list[i];
+		int index = rapl_domain_index(domain.type);
+
+		// With sub domains, the first one of a type is reported
+		if (index < 0 || snapshot[index].valid || !domain.last_read_ns)
+			continue;
+
+		snapshot[index].valid = true;
+		snapshot[index].power = domain.power;
+		snapshot[index].max_power = domain.max_power;
+		snapshot[index].min_power = domain.min_power;
+		snapshot[index].avg_power_1s = rapl_window_power(domain, 1000000000LL);
+		snapshot[index].avg_power_10s = rapl_window_power(domain,
+				10000000000LL);
+		snapshot[index].avg_power_60s = rapl_window_power(domain,
+				60000000000LL);
+		snapshot[index].energy = domain.energy_total;
+		snapshot[index].time_ns = domain.last_read_ns;
+	}
+
+	unsigned int seq = snapshot_seq.load(std::memory_order_relaxed);
+	snapshot_seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(published, snapshot, sizeof(published));
+	snapshot_seq.store(seq + 2, std::memory_order_release);
+}
+
+bool cthd_rapl_power_meter::rapl_get_power_snapshot(domain_type type,
+		rapl_power_snapshot_t *snapshot) {
+	int index = rapl_domain_index(type);
+	unsigned int seq;
+
+	if (index < 0 || !rapl_present)
+		return false;
+
+	do {
+		seq = snapshot_seq.load(std::memory_order_acquire);
+		if (seq & 1)
+			continue;
+		memcpy(snapshot, &published[index], sizeof(*snapshot));
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((seq & 1) || seq != snapshot_seq.load(std::memory_order_relaxed));
+
+	return snapshot->valid;
+}
+
 unsigned long long cthd_rapl_power_meter::rapl_action_get_energy(
 		domain_type type) {
 	unsigned long long value = 0;
 
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
 		if (type == domain_list[i].type) {
-			value = (domain_list[i].energy_counter
-					+ domain_list[i].energy_cumulative_counter) * 1000;
-			if (!value) {
+			if (!domain_list[i].last_read_ns)
 				rapl_energy_loop();
-				value = (domain_list[i].energy_counter
-						+ domain_list[i].energy_cumulative_counter) * 1000;
-			}
+			value = domain_list[i].energy_total;
 
 			break;
 		}
@@ -227,6 +363,7 @@ unsigned long long cthd_rapl_power_meter::rapl_action_get_energy(
 	return value;
 }
 
+// Never blocks: till two samples are read, power is 0
 unsigned int cthd_rapl_power_meter::rapl_action_get_power(domain_type type) {
 	unsigned int value = 0;
 
@@ -235,13 +372,9 @@ unsigned int cthd_rapl_power_meter::rapl_action_get_power(domain_type type) {
 
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
 		if (type == domain_list[i].type) {
-			value = domain_list[i].power * 1000;
-			if (!value) {
-				rapl_energy_loop();
-				sleep(1);
+			if (!domain_list[i].power)
 				rapl_energy_loop();
-				value = domain_list[i].power * 1000;
-			}
+			value = domain_list[i].power;
 			break;
 		}
 	}
@@ -249,6 +382,25 @@ unsigned int cthd_rapl_power_meter::rapl_action_get_power(domain_type type) {
 	return value;
 }
 
+unsigned int cthd_rapl_power_meter::rapl_action_get_power_avg(
+		domain_type type, rapl_power_window_t window) {
+	rapl_power_snapshot_t snapshot;
+
+	if (!rapl_get_power_snapshot(type, &snapshot))
+		return 0;
+
+	switch (window) {
+	case RAPL_POWER_AVG_1S:
+		return snapshot.avg_power_1s;
+	case RAPL_POWER_AVG_10S:
+		return snapshot.avg_power_10s;
+	case RAPL_POWER_AVG_60S:
+		return snapshot.avg_power_60s;
+	default:
+		return snapshot.power;
+	}
+}
+
 unsigned int cthd_rapl_power_meter::rapl_action_get_max_power(
 		domain_type type) {
 	unsigned int value = 0;
@@ -258,29 +410,20 @@ unsigned int cthd_rapl_power_meter::rapl_action_get_max_power(
 
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
 		if (type == domain_list[i].type) {
-			int status;
-			std::string _path;
-			csys_fs sys_fs;
 			int max_power;
-			unsigned int const_0_val = 0, const_1_val = 0;
-
-			const_0_val = 0;
-			const_1_val = 0;
-			_path = domain_list[i].path + "/" + "constraint_0_max_power_uw";
-			status = sys_fs.read(_path, &max_power);
-			if (status >= 0) {
-				if (max_power > 0)
-					const_0_val = max_power;
-			}
+			unsigned int const_val[2] = { 0, 0 };
 
-			_path = domain_list[i].path + "/" + "constraint_1_max_power_uw";
-			status = sys_fs.read(_path, &max_power);
-			if (status >= 0) {
-				if (max_power > 0)
-					const_1_val = max_power;
+			for (int j = 0; j < 2; ++j) {
+				csys_fs_attr *attr =
+						domain_list[i].constraint_max_power_attr[j].get();
+
+				if (!attr->is_open())
+					continue;
+				if (attr->read(&max_power) > 0 && max_power > 0)
+					const_val[j] = max_power;
 			}
 
-			value = const_1_val > const_0_val ? const_1_val : const_0_val;
+			value = const_val[1] > const_val[0] ? const_val[1] : const_val[0];
 			if (value)
 				return value;
 		}
@@ -298,7 +441,7 @@ unsigned int cthd_rapl_power_meter::rapl_action_get_last_power(domain_type type)
 
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
 		if (type == domain_list[i].type) {
-			value = domain_list[i].power * 1000;
+			value = domain_list[i].power;
 			break;
 		}
 	}
@@ -315,15 +458,11 @@ unsigned int cthd_rapl_power_meter::rapl_action_get_power(domain_type type,
 
 	for (unsigned int i = 0; i < domain_list.size(); ++i) {
 		if (type == domain_list[i].type) {
-			value = domain_list[i].power * 1000;
-			if (!value) {
+			if (!domain_list[i].power)
 				rapl_energy_loop();
-				sleep(1);
-				rapl_energy_loop();
-				value = domain_list[i].power * 1000;
-			}
-			*max_power = domain_list[i].max_power * 1000;
-			*min_power = domain_list[i].min_power * 1000;
+			value = domain_list[i].power;
+			*max_power = domain_list[i].max_power;
+			*min_power = domain_list[i].min_power;
 			break;
 		}
 	}
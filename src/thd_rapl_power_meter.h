@@ -27,26 +27,65 @@
 
 #include "thd_common.h"
 #include "thd_sys_fs.h"
+#include "thd_timer_service.h"
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 typedef enum : uint8_t {
 	INVALID = 0, PACKAGE = 0x01, DRAM = 0x02, CORE = 0x04, UNCORE = 0x08
 } domain_type;
 
+// Averaging windows for the power computed from energy counters
+typedef enum : uint8_t {
+	RAPL_POWER_INSTANT, RAPL_POWER_AVG_1S, RAPL_POWER_AVG_10S, RAPL_POWER_AVG_60S
+} rapl_power_window_t;
+
+// Enough for 60 seconds at the minimum spacing of stored samples
+#define RAPL_POWER_SAMPLES	128
+
+typedef struct {
+	long long time_ns;
+	unsigned long long energy; // Unwrapped, micro joules
+} rapl_power_sample_t;
+
+#define RAPL_DOMAIN_TYPES	4
+
+// Power values published after every read for lock free readers, micro units
+typedef struct {
+	bool valid;
+	unsigned int power;
+	unsigned int max_power;
+	unsigned int min_power;
+	unsigned int avg_power_1s;
+	unsigned int avg_power_10s;
+	unsigned int avg_power_60s;
+	unsigned long long energy;
+	long long time_ns;
+} rapl_power_snapshot_t;
+
 typedef struct {
 	domain_type type;
 	std::string name;
 	std::string path;
-	// Store in milli-units to have a bigger range
+	// All energy values are in micro joules as in powercap ABI
 	unsigned long long max_energy_range;
-	unsigned long long max_energy_range_threshold;
-	int half_way;
-	unsigned long long energy_cumulative_counter;
-	unsigned long long energy_counter;
+	unsigned long long energy_counter; // Last raw energy_uj
+	unsigned long long energy_total; // Unwrapped since first read
+	long long last_read_ns;
+	// Power in micro watts
 	unsigned int power;
 	unsigned int max_power;
 	unsigned int min_power;
+	// Ring buffer of unwrapped energy samples for window averages
+	rapl_power_sample_t samples[RAPL_POWER_SAMPLES];
+	unsigned int sample_head;
+	unsigned int sample_count;
+	// Opened once when the domain is found, read with pread()
+	std::unique_ptr<csys_fs_attr> energy_attr;
+	std::unique_ptr<csys_fs_attr> max_energy_range_attr;
+	std::unique_ptr<csys_fs_attr> constraint_max_power_attr[2];
 } rapl_domain_t;
 
 class cthd_rapl_power_meter {
@@ -54,23 +93,35 @@ private:
 	bool rapl_present;
 	csys_fs rapl_sysfs;
 	std::vector<rapl_domain_t> domain_list;
-	time_t last_time;
-	pthread_t poll_thread;
-	pthread_attr_t thd_attr;
+	long long last_time_ns;
 	unsigned int measure_mask;
 	bool enable_measurement;
+	cthd_timer_service *timer_service;
+	int timer_id;
+	// Seqlock: odd while the engine thread updates published[]
+	std::atomic<unsigned int> snapshot_seq;
+	rapl_power_snapshot_t published[RAPL_DOMAIN_TYPES];
+
+	void rapl_publish_snapshot();
+	void rapl_store_sample(rapl_domain_t &domain, long long time_ns);
+	unsigned int rapl_window_power(rapl_domain_t &domain, long long window_ns);
 
 public:
 	static constexpr int rapl_callback_timeout = 10; //seconds
+	static constexpr int rapl_timer_slack = 2000; // In msec
+	// Reads closer than this are too noisy to compute power
+	static constexpr long long rapl_min_read_interval_ns = 100000000LL;
+	// Minimum spacing of samples kept for the window averages
+	static constexpr long long rapl_sample_interval_ns = 500000000LL;
+
 	cthd_rapl_power_meter(unsigned int mask = PACKAGE | DRAM);
 
 	void rapl_read_domains(const char *base_path);
-	void rapl_enable_periodic_timer();
+	void rapl_open_domain_attrs(rapl_domain_t &domain);
+	void rapl_enable_periodic_timer(cthd_timer_service &service);
 	bool rapl_energy_loop();
 	void rapl_measure_power();
-	void rapl_start_measure_power() {
-		enable_measurement = true;
-	}
+	void rapl_start_measure_power();
 	void rapl_stop_measure_power() {
 		enable_measurement = false;
 	}
@@ -81,7 +132,13 @@ public:
 	unsigned int rapl_action_get_power(domain_type type);
 	unsigned int rapl_action_get_power(domain_type type,
 			unsigned int *max_power, unsigned int *min_power);
+	unsigned int rapl_action_get_power_avg(domain_type type,
+			rapl_power_window_t window);
 	unsigned int rapl_action_get_max_power(domain_type type);
+
+	// Doesn't block or read sysfs, safe to call from any thread
+	bool rapl_get_power_snapshot(domain_type type,
+			rapl_power_snapshot_t *snapshot);
 };
 
 #endif
@@ -0,0 +1,76 @@
+/*
+ * thd_sample_scheduler.cpp: zone sampling scheduler implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Each zone is sampled at the fastest period requested by any of its
+ * sensors. Instead of waking up on one global poll timeout and reading
+ * every zone, the engine keeps one deadline per zone in this heap and
+ * sleeps until the earliest one expires.
+ */
+
+#include <algorithm>
+#include <climits>
+#include "thd_sample_scheduler.h"
+
+void cthd_sample_scheduler::schedule(cthd_zone *zone, long long deadline) {
+	sample_entry_t entry;
+
+	entry.deadline = deadline;
+	entry.zone = zone;
+	heap.push_back(entry);
+	std::push_heap(heap.begin(), heap.end(), entry_later);
+}
+
+// Return the next zone whose deadline expired or nullptr
+cthd_zone *cthd_sample_scheduler::pop_due(long long now) {
+	if (heap.empty() || heap.front().deadline > now)
+		return nullptr;
+
+	std::pop_heap(heap.begin(), heap.end(), entry_later);
+	cthd_zone *zone = heap.back().zone;
+	heap.pop_back();
+
+	return zone;
+}
+
+// Return poll() timeout in msec till the earliest deadline, -1 when idle
+int cthd_sample_scheduler::get_timeout(long long now) {
+	if (heap.empty())
+		return -1;
+
+	long long timeout = heap.front().deadline - now;
+	if (timeout < 0)
+		return 0;
+	if (timeout > INT_MAX)
+		return INT_MAX;
+
+	return (int) timeout;
+}
+
+// Return the earliest deadline, -1 when idle
+long long cthd_sample_scheduler::get_next_deadline() {
+	if (heap.empty())
+		return -1;
+
+	return heap.front().deadline;
+}
@@ -0,0 +1,61 @@
+/*
+ * thd_sample_scheduler.h: zone sampling scheduler interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_SAMPLE_SCHEDULER_H_
+#define THD_SAMPLE_SCHEDULER_H_
+
+#include <vector>
+
+class cthd_zone;
+
+// Min-heap of zone sampling deadlines in monotonic msec. The engine sleeps
+// until the earliest deadline and then samples only the zones which are due.
+class cthd_sample_scheduler {
+private:
+	typedef struct {
+		long long deadline;
+		cthd_zone *zone;
+	} sample_entry_t;
+
+	std::vector<sample_entry_t> heap;
+
+	static bool entry_later(const sample_entry_t &a, const sample_entry_t &b) {
+		return a.deadline > b.deadline;
+	}
+
+public:
+	void schedule(cthd_zone *zone, long long deadline);
+	cthd_zone *pop_due(long long now);
+	int get_timeout(long long now);
+	long long get_next_deadline();
+
+	void clear() {
+		heap.clear();
+	}
+	bool empty() {
+		return heap.empty();
+	}
+};
+
+#endif /* THD_SAMPLE_SCHEDULER_H_ */
@@ -29,7 +29,9 @@ cthd_sensor::cthd_sensor(int _index, std::string control_path,
 		std::string _type_str, int _type) :
 		index(_index), type(_type), sensor_sysfs(std::move(control_path)), sensor_active(
 				false), type_str(std::move(_type_str)), async_capable(false), virtual_sensor(
-				false), thresholds(0), scale(1) {
+				false), poll_mode(false), fast_poll_mode(false), snapshot(nullptr), snapshot_slot(
+				-1), cached_time(0), cached_temp(0), sysfs_reads(0), sysfs_read_errors(
+				0), thresholds(0), scale(1) {
 
 }
 
@@ -61,18 +63,84 @@ int cthd_sensor::sensor_update() {
 	return THD_SUCCESS;
 }
 
+int cthd_sensor::register_snapshot(csys_fs_snapshot *snap) {
+	if (snapshot)
+		return snapshot_slot;
+
+	if (virtual_sensor)
+		return THD_ERROR;
+
+	std::string path = sensor_sysfs.get_base_path();
+	if (type == SENSOR_TYPE_THERMAL_SYSFS)
+		path += "temp";
+
+	int slot = snap->add(path);
+	if (slot < 0)
+		return slot;
+
+	snapshot = snap;
+	snapshot_slot = slot;
+
+	return slot;
+}
+
+// Return true with the cached reading, when it was taken in the current
+// sampling tick or is not older than the allowed staleness
+bool cthd_sensor::read_cached_temp(unsigned int *temp) {
+	long long time = cached_time.load(std::memory_order_acquire);
+
+	if (!time)
+		return false;
+
+	if (time < thd_engine->get_sample_tick_time()
+			&& thd_get_monotonic_msec() - time > thd_sensor_max_staleness)
+		return false;
+
+	*temp = cached_temp.load(std::memory_order_relaxed);
+
+	return true;
+}
+
+void cthd_sensor::update_cached_temp(unsigned int temp) {
+	cached_temp.store(temp, std::memory_order_relaxed);
+	cached_time.store(thd_get_monotonic_msec(), std::memory_order_release);
+	thd_engine->get_trace().record(TRACE_SAMPLE, index, 0, temp);
+}
+
 unsigned int cthd_sensor::read_temperature() {
-	csys_fs sysfs;
-	int temp, ret;
+	int temp = 0, ret;
+	long long value;
+	unsigned int cached;
 
 	thd_log_debug("read_temperature sensor ID %d\n", index);
-	if (type == SENSOR_TYPE_THERMAL_SYSFS)
-		ret = sensor_sysfs.read("temp", &temp);
-	else
-		ret = sensor_sysfs.read("", &temp);
+	if (snapshot && snapshot->get(snapshot_slot, &value) == THD_SUCCESS) {
+		temp = (int) value;
+		ret = 0;
+	} else if (read_cached_temp(&cached)) {
+		return cached;
+	} else if (thd_replay_file) {
+		// Only recorded samples, never the running system
+		return cached_temp.load(std::memory_order_relaxed);
+	} else {
+		if (!temp_attr.is_open()) {
+			if (type == SENSOR_TYPE_THERMAL_SYSFS)
+				temp_attr.open(sensor_sysfs.get_base_path() + "temp");
+			else
+				temp_attr.open(sensor_sysfs.get_base_path());
+		}
+		if (temp_attr.is_open())
+			ret = temp_attr.read(&temp);
+		else
+			ret = -1;
+		if (ret < 0)
+			sysfs_read_errors.fetch_add(1, std::memory_order_relaxed);
+	}
+	sysfs_reads.fetch_add(1, std::memory_order_relaxed);
 	if (ret < 0 || temp < 0)
 		temp = 0;
 	thd_log_debug("Sensor %s :temp %u\n", type_str.c_str(), temp);
+	update_cached_temp((unsigned int)temp / scale);
+
 	return (unsigned int)temp / scale;
 }
 
@@ -25,6 +25,7 @@
 #ifndef THD_SENSOR_H_
 #define THD_SENSOR_H_
 
+#include <atomic>
 #include <vector>
 #include "thd_common.h"
 #include "thd_sys_fs.h"
@@ -38,10 +39,24 @@ protected:
 	int index;
 	int type;
 	csys_fs sensor_sysfs;
+	csys_fs_attr temp_attr;
 	bool sensor_active;
 	std::string type_str;
 	bool async_capable;
 	bool virtual_sensor;
+	bool poll_mode;
+	bool fast_poll_mode;
+	csys_fs_snapshot *snapshot;
+	int snapshot_slot;
+	// Last reading, shared by all readers in a sampling tick and by
+	// readers outside of it for thd_sensor_max_staleness msec
+	std::atomic<long long> cached_time;
+	std::atomic<unsigned int> cached_temp;
+	std::atomic<unsigned long> sysfs_reads;
+	std::atomic<unsigned long> sysfs_read_errors;
+
+	bool read_cached_temp(unsigned int *temp);
+	void update_cached_temp(unsigned int temp);
 
 private:
 	std::vector<int> thresholds;
@@ -75,6 +90,12 @@ public:
 			return;
 		}
 		sensor_sysfs.update_path(std::move(str));
+		temp_attr.close();
+		// Registered again with the new path on the next schedule rebuild
+		if (snapshot)
+			snapshot->remove(snapshot_slot);
+		snapshot = nullptr;
+		snapshot_slot = -1;
 	}
 	void set_async_capable(bool capable) {
 		async_capable = capable;
@@ -95,9 +116,50 @@ public:
 
 	void sensor_fast_poll(bool status);
 
+	// Set by the engine when a polling trip of this sensor requested
+	// polling or fast polling, used to compute its sampling period
+	void set_poll_mode(bool status) {
+		poll_mode = status;
+	}
+	bool check_poll_mode() {
+		return poll_mode;
+	}
+	void set_fast_poll_mode(bool status) {
+		fast_poll_mode = status;
+	}
+	bool check_fast_poll_mode() {
+		return fast_poll_mode;
+	}
+
+	// Register temperature attribute with the engine batch reader. When the
+	// snapshot holds a value for this tick, read_temperature() uses it.
+	virtual int register_snapshot(csys_fs_snapshot *snap);
+	int get_snapshot_slot() {
+		return snapshot_slot;
+	}
+
+	// Readings from sysfs or the tick snapshot, for the engine stats
+	unsigned long get_sysfs_reads() {
+		return sysfs_reads.load(std::memory_order_relaxed);
+	}
+	unsigned long get_sysfs_read_errors() {
+		return sysfs_read_errors.load(std::memory_order_relaxed);
+	}
+
 	bool is_virtual() {
 		return virtual_sensor;
 	}
+
+	// Last reading without any sysfs access, time is 0 before the first one
+	unsigned int get_last_temp(long long *time) {
+		*time = cached_time.load(std::memory_order_acquire);
+		return cached_temp.load(std::memory_order_relaxed);
+	}
+
+	// Replay: a recorded sample is the current reading
+	virtual void set_replay_temp(unsigned int temp) {
+		update_cached_temp(temp);
+	}
 };
 
 #endif /* THD_SENSOR_H_ */
@@ -0,0 +1,114 @@
+/*
+ * thd_sensor_graph.cpp: virtual sensor dependency graph implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Virtual sensors can link other virtual sensors. The links are sorted
+ * once when sensors are loaded (Kahn's algorithm). Sensors which are left
+ * over are part of a cycle; they are reported and read as 0 instead of
+ * recursing forever.
+ */
+
+#include <unordered_map>
+#include "thd_sensor_graph.h"
+#include "thd_sensor_virtual.h"
+
+int cthd_sensor_graph::build(std::vector<std::unique_ptr<cthd_sensor>> &sensors) {
+	std::unordered_map<cthd_sensor_virtual *, int> in_degree;
+	std::unordered_map<cthd_sensor_virtual *, std::vector<cthd_sensor_virtual *>> users;
+	std::vector<cthd_sensor_virtual *> nodes;
+	int ret = THD_SUCCESS;
+
+	order.clear();
+
+	for (unsigned int i = 0; i < sensors.size(); ++i) {
+		if (!sensors[i]->is_virtual())
+			continue;
+
+		cthd_sensor_virtual *sensor = (cthd_sensor_virtual *) sensors[i].get();
+		nodes.push_back(sensor);
+		in_degree[sensor] = 0;
+	}
+
+	for (cthd_sensor_virtual *sensor : nodes) {
+		for (unsigned int i = 0; i < sensor->get_link_count(); ++i) {
+			cthd_sensor *link = sensor->get_link_sensor(i);
+
+			if (!link || !link->is_virtual())
+				continue;
+
+			users[(cthd_sensor_virtual *) link].push_back(sensor);
+			++in_degree[sensor];
+		}
+	}
+
+	for (cthd_sensor_virtual *sensor : nodes) {
+		if (!in_degree[sensor])
+			order.push_back(sensor);
+	}
+
+	for (unsigned int i = 0; i < order.size(); ++i) {
+		for (cthd_sensor_virtual *user : users[order[i]]) {
+			if (!--in_degree[user])
+				order.push_back(user);
+		}
+	}
+
+	for (cthd_sensor_virtual *sensor : nodes) {
+		bool in_cycle = in_degree[sensor] > 0;
+
+		if (in_cycle) {
+			thd_log_warn("Virtual sensor %s is in or depends on a link cycle\n",
+					sensor->get_sensor_type().c_str());
+			ret = THD_ERROR;
+		}
+		sensor->set_in_cycle(in_cycle);
+	}
+
+	thd_log_debug("virtual sensor graph: %zu sensors\n", order.size());
+
+	return ret;
+}
+
+// Update periodic virtual sensors which are due
+void cthd_sensor_graph::process(long long now) {
+	for (cthd_sensor_virtual *sensor : order) {
+		if (sensor->is_polling() && sensor->get_next_poll_time() <= now)
+			sensor->periodic_update(now);
+	}
+}
+
+// Return the earliest periodic update, -1 when none is polling
+long long cthd_sensor_graph::get_next_deadline() {
+	long long deadline = -1;
+
+	for (cthd_sensor_virtual *sensor : order) {
+		if (!sensor->is_polling())
+			continue;
+
+		long long next = sensor->get_next_poll_time();
+		if (deadline < 0 || next < deadline)
+			deadline = next;
+	}
+
+	return deadline;
+}
@@ -0,0 +1,51 @@
+/*
+ * thd_sensor_graph.h: virtual sensor dependency graph interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_SENSOR_GRAPH_H_
+#define THD_SENSOR_GRAPH_H_
+
+#include <memory>
+#include <vector>
+
+class cthd_sensor;
+class cthd_sensor_virtual;
+
+// All virtual sensors ordered so that a sensor comes after every virtual
+// sensor it links to. Periodic virtual sensors are updated from the engine
+// loop in this order, so each one sees inputs of the same pass.
+class cthd_sensor_graph {
+private:
+	std::vector<cthd_sensor_virtual *> order;
+
+public:
+	int build(std::vector<std::unique_ptr<cthd_sensor>> &sensors);
+	void process(long long now);
+	long long get_next_deadline();
+
+	void clear() {
+		order.clear();
+	}
+};
+
+#endif /* THD_SENSOR_GRAPH_H_ */
@@ -36,7 +36,12 @@ cthd_sensor_rapl_power::cthd_sensor_rapl_power(int index) :
 unsigned int cthd_sensor_rapl_power::read_temperature() {
 	thd_engine->rapl_power_meter.rapl_start_measure_power();
 
-	unsigned int pkg_power = thd_engine->rapl_power_meter.rapl_action_get_last_power(PACKAGE);
+	rapl_power_snapshot_t snapshot;
+	unsigned int pkg_power = 0;
+
+	if (thd_engine->rapl_power_meter.rapl_get_power_snapshot(PACKAGE,
+			&snapshot))
+		pkg_power = snapshot.power;
 
 	pkg_power = (pkg_power / 1000);
 	thd_log_debug("Sensor %s :power %u\n", type_str.c_str(), pkg_power);
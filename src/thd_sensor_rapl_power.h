@@ -32,6 +32,10 @@ private:
 public:
 	cthd_sensor_rapl_power(int index);
 	unsigned int read_temperature() override;
+	// Power is computed by the RAPL meter, nothing to read in batch
+	int register_snapshot(csys_fs_snapshot *snap) override {
+		return THD_ERROR;
+	}
 };
 
 #endif
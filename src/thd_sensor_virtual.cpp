@@ -28,8 +28,8 @@
 cthd_sensor_virtual::cthd_sensor_virtual(int _index, std::string _type_str,
 		std::string& _link_type_str, double _multiplier, double _offset) :
 		cthd_sensor(_index, "none", std::move(_type_str)),
-		multiplier(_multiplier), offset(_offset), poll_thread(0), polling(false),
-		poll_thread_started(false), stop_polling(false), last_temp(0),
+		multiplier(_multiplier), offset(_offset), polling(false),
+		next_poll_time(0), in_cycle(false), last_temp(0),
 		polling_period(def_polling_period) {
 
 	if (!_link_type_str.empty()) {
@@ -97,10 +97,22 @@ int cthd_sensor_virtual::sensor_update() {
 }
 
 unsigned int cthd_sensor_virtual::read_temperature() {
+	unsigned int temp;
+
+	if (in_cycle)
+		return 0;
+
 	if (polling.load())
 		return static_cast<unsigned int>(last_temp.load());
 
-	return _read_temperature();
+	// Every evaluation moves the running averages, so do it once per tick
+	if (read_cached_temp(&temp))
+		return temp;
+
+	temp = _read_temperature();
+	update_cached_temp(temp);
+
+	return temp;
 }
 
 unsigned int cthd_sensor_virtual::_read_temperature() {
@@ -112,6 +124,9 @@ unsigned int cthd_sensor_virtual::_read_temperature() {
 		return 0;
 	}
 
+	if (in_cycle)
+		return 0;
+
 	link_sensor_t *link_sensor = link_sensors[0];
 
 	if (link_sensor && link_sensor->sensor && !link_sensor->coeff && !link_sensor->offset) {
@@ -197,40 +212,34 @@ void cthd_sensor_virtual::update_polling_table(struct polling_table_entry& entry
 		polling_table.push_back(entry);
 }
 
-static void *periodic_callback(void *data) {
-	cthd_sensor_virtual *sensor = (cthd_sensor_virtual *) data;
+// Called from the engine loop, in dependency order of virtual sensors
+void cthd_sensor_virtual::periodic_update(long long now) {
+	int prev_temp = last_temp.load();
 
-	for (;;) {
-		if (sensor->stop_polling.load()) {
-			thd_log_info("periodic callback exit\n");
-			break;
-		}
-
-		sensor->_read_temperature();
-
-		int period = 0;
-		for (size_t i = sensor->polling_table.size(); i > 0; --i) {
-				struct polling_table_entry entry = sensor->polling_table[i - 1];
+	_read_temperature();
+	if (last_temp.load() != prev_temp)
+		thd_engine->thd_engine_sensor_changed(index);
 
-				if (sensor->last_temp.load() >= entry.virtual_temp) {
-					period = entry.sample_period;
-					break;
-				}
-		}
+	int period = 0;
+	for (size_t i = polling_table.size(); i > 0; --i) {
+		struct polling_table_entry entry = polling_table[i - 1];
 
-		if (period) {
-			sensor->polling_period.store(period);
-			thd_log_debug("Update Sample period is set to %d seconds\n", period);
+		if (last_temp.load() >= entry.virtual_temp) {
+			period = entry.sample_period;
+			break;
 		}
+	}
 
-		int sleep_period = sensor->polling_period.load();
-		if (sleep_period <= 0)
-			sleep_period = cthd_sensor_virtual::def_polling_period;
-
-		sleep(sleep_period);
+	if (period) {
+		polling_period.store(period);
+		thd_log_debug("Update Sample period is set to %d seconds\n", period);
 	}
 
-	return nullptr;
+	int sleep_period = polling_period.load();
+	if (sleep_period <= 0)
+		sleep_period = def_polling_period;
+
+	next_poll_time = now + sleep_period * 1000LL;
 }
 
 void cthd_sensor_virtual::enable_periodic_timer()
@@ -253,17 +262,8 @@ void cthd_sensor_virtual::enable_periodic_timer()
 	if (polling.load())
 		return;
 
-	stop_polling.store(false);
-	pthread_attr_init(&thd_attr);
-	pthread_attr_setdetachstate(&thd_attr, PTHREAD_CREATE_JOINABLE);
-
-	if (pthread_create(&poll_thread, &thd_attr, periodic_callback, (void*) this) != 0) {
-		thd_log_warn("Virtual sensor periodic timer create failed\n");
-		pthread_attr_destroy(&thd_attr);
-		return;
-	}
-
-	poll_thread_started = true;
+	// First update on the next engine wakeup
+	next_poll_time = 0;
 	polling.store(true);
 }
 
@@ -273,14 +273,5 @@ void cthd_sensor_virtual::disable_periodic_timer()
 		return;
 
 	thd_log_info("Virtual sensor periodic timer disabled\n");
-	stop_polling.store(true);
-
-	if (poll_thread_started) {
-		pthread_join(poll_thread, nullptr);
-		poll_thread_started = false;
-		pthread_attr_destroy(&thd_attr);
-	}
-
 	polling.store(false);
 }
-
@@ -49,12 +49,11 @@ private:
 	double multiplier;
 	double offset;
 
-	pthread_t poll_thread;
-	pthread_attr_t thd_attr;
 	std::atomic<bool> polling;
-	bool poll_thread_started;
+	// Monotonic msec of the next periodic update from the engine loop
+	long long next_poll_time;
+	bool in_cycle;
 public:
-	std::atomic<bool> stop_polling;
 	std::atomic<int> last_temp;
 
 	static const int def_polling_period = 5; //seconds
@@ -70,6 +69,10 @@ public:
 	int sensor_update();
 	unsigned int _read_temperature();
 	unsigned int read_temperature() override;
+	void set_replay_temp(unsigned int temp) override {
+		last_temp.store(temp);
+		update_cached_temp(temp);
+	}
 	void sensor_dump() override {
 		thd_log_info("Sensor:%s \n", type_str.c_str());
 
@@ -87,6 +90,26 @@ public:
 	int sensor_update_param(const std::string& new_dep_sensor, double slope, double intercept);
 	void enable_periodic_timer();
 	void disable_periodic_timer();
+	void periodic_update(long long now);
+
+	bool is_polling() {
+		return polling.load();
+	}
+	long long get_next_poll_time() {
+		return next_poll_time;
+	}
+
+	unsigned int get_link_count() {
+		return link_sensors.size();
+	}
+	cthd_sensor *get_link_sensor(unsigned int i) {
+		if (i < link_sensors.size())
+			return link_sensors[i]->sensor;
+		return nullptr;
+	}
+	void set_in_cycle(bool status) {
+		in_cycle = status;
+	}
 	void update_polling_table(struct polling_table_entry& entry);
 };
 
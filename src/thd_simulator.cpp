@@ -0,0 +1,544 @@
+/*
+ * thd_simulator.cpp: closed loop thermal plant simulator
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include "thd_simulator.h"
+#include "thd_engine.h"
+#include "thd_util.h"
+
+static constexpr double def_ambient_temp = 25.0;
+
+cthd_simulator::cthd_simulator() :
+		duration(0), time_step(100), sample_period(1000), settle_band(1.0), elapsed(
+				0) {
+}
+
+// Piecewise linear, two points at the same time make a step
+double cthd_simulator::profile_value(
+		const std::vector<profile_point_t> &profile, double time, double def) {
+	if (profile.empty())
+		return def;
+
+	if (time <= profile.front().time)
+		return profile.front().value;
+
+	unsigned int i = profile.size() - 1;
+	while (profile[i].time > time)
+		--i;
+
+	if (i == profile.size() - 1)
+		return profile[i].value;
+
+	const profile_point_t &next = profile[i + 1];
+
+	return profile[i].value
+			+ (next.value - profile[i].value) * (time - profile[i].time)
+					/ (next.time - profile[i].time);
+}
+
+// Time of the last change in a profile
+double cthd_simulator::profile_end(const std::vector<profile_point_t> &profile) {
+	for (unsigned int i = profile.size(); i > 1; --i) {
+		if (profile[i - 1].value != profile[i - 2].value)
+			return profile[i - 1].time;
+	}
+
+	return 0;
+}
+
+int cthd_simulator::parse_profile(xmlNode *a_node, xmlDoc *doc,
+		std::vector<profile_point_t> &profile) {
+	xmlNode *cur_node = nullptr;
+	char *tmp_value;
+
+	for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
+		if (cur_node->type != XML_ELEMENT_NODE
+				|| thd_strcasecmp_n((const char*) cur_node->name, "Point"))
+			continue;
+
+		profile_point_t point = { -1, 0 };
+		for (xmlNode *node = cur_node->children; node; node = node->next) {
+			if (node->type != XML_ELEMENT_NODE)
+				continue;
+			tmp_value = (char*) xmlNodeListGetString(doc, node->xmlChildrenNode,
+					1);
+			if (tmp_value) {
+				if (!thd_strcasecmp_n((const char*) node->name, "Time"))
+					point.time = atof(tmp_value);
+				else if (!thd_strcasecmp_n((const char*) node->name, "Value"))
+					point.value = atof(tmp_value);
+				xmlFree(tmp_value);
+			}
+		}
+
+		if (point.time < 0
+				|| (!profile.empty() && point.time < profile.back().time)) {
+			thd_log_warn("simulator: profile points need increasing Time\n");
+			return THD_ERROR;
+		}
+		profile.push_back(point);
+	}
+
+	return THD_SUCCESS;
+}
+
+int cthd_simulator::parse_cdev(xmlNode *a_node, xmlDoc *doc, sim_cdev_t *cdev) {
+	xmlNode *cur_node = nullptr;
+	char *tmp_value;
+
+	cdev->max_state = 0;
+	cdev->power_reduction = 0;
+	cdev->inc_dec_step = 1;
+	cdev->debounce_interval = cthd_cdev::default_debounce_interval;
+	cdev->influence = cthd_trip_point::default_influence;
+	cdev->pid.valid = 0;
+	cdev->cdev = nullptr;
+	cdev->last_state = 0;
+	cdev->last_direction = 0;
+	cdev->reversals = 0;
+
+	for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
+		if (cur_node->type != XML_ELEMENT_NODE)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "PidControl")) {
+			cdev->pid.valid = 1;
+			cdev->pid.kp = cdev->pid.ki = cdev->pid.kd = 0;
+			for (xmlNode *node = cur_node->children; node; node = node->next) {
+				if (node->type != XML_ELEMENT_NODE)
+					continue;
+				tmp_value = (char*) xmlNodeListGetString(doc,
+						node->xmlChildrenNode, 1);
+				if (tmp_value) {
+					if (!thd_strcasecmp_n((const char*) node->name, "Kp"))
+						cdev->pid.kp = atof(tmp_value);
+					else if (!thd_strcasecmp_n((const char*) node->name, "Ki"))
+						cdev->pid.ki = atof(tmp_value);
+					else if (!thd_strcasecmp_n((const char*) node->name, "Kd"))
+						cdev->pid.kd = atof(tmp_value);
+					xmlFree(tmp_value);
+				}
+			}
+			continue;
+		}
+
+		tmp_value = (char*) xmlNodeListGetString(doc, cur_node->xmlChildrenNode,
+				1);
+		if (!tmp_value)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Type"))
+			cdev->type.assign(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "MaxState"))
+			cdev->max_state = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"PowerReduction"))
+			cdev->power_reduction = atof(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "IncDecStep"))
+			cdev->inc_dec_step = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"DebouncePeriod"))
+			cdev->debounce_interval = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "Influence"))
+			cdev->influence = atoi(tmp_value);
+		xmlFree(tmp_value);
+	}
+
+	if (cdev->type.empty() || cdev->max_state <= 0
+			|| cdev->power_reduction < 0 || cdev->power_reduction > 1) {
+		thd_log_warn(
+				"simulator: cooling device needs Type, MaxState and PowerReduction 0..1\n");
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
+int cthd_simulator::parse_zone(xmlNode *a_node, xmlDoc *doc, sim_zone_t *zone) {
+	xmlNode *cur_node = nullptr;
+	char *tmp_value;
+
+	zone->resistance = 0;
+	zone->capacitance = 0;
+	zone->idle_power = 0;
+	zone->initial_temp_valid = false;
+	zone->initial_temp = 0;
+	zone->trip_temp = 0;
+	zone->hyst = 0;
+	zone->control_type = PARALLEL;
+	zone->sensor = nullptr;
+
+	for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
+		if (cur_node->type != XML_ELEMENT_NODE)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Load")) {
+			if (parse_profile(cur_node->children, doc, zone->load)
+					!= THD_SUCCESS)
+				return THD_ERROR;
+			continue;
+		}
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "CoolingDevice")) {
+			sim_cdev_t cdev;
+
+			if (parse_cdev(cur_node->children, doc, &cdev) != THD_SUCCESS)
+				return THD_ERROR;
+			zone->cdevs.push_back(cdev);
+			continue;
+		}
+
+		tmp_value = (char*) xmlNodeListGetString(doc, cur_node->xmlChildrenNode,
+				1);
+		if (!tmp_value)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Type"))
+			zone->type.assign(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"ThermalResistance"))
+			zone->resistance = atof(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"ThermalCapacitance"))
+			zone->capacitance = atof(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "IdlePower"))
+			zone->idle_power = atof(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"InitialTemperature")) {
+			zone->initial_temp = atof(tmp_value);
+			zone->initial_temp_valid = true;
+		} else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"Temperature"))
+			zone->trip_temp = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "Hyst"))
+			zone->hyst = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "ControlType")) {
+			if (!thd_strcasecmp_n(tmp_value, "SEQUENTIAL"))
+				zone->control_type = SEQUENTIAL;
+		}
+		xmlFree(tmp_value);
+	}
+
+	if (zone->type.empty() || zone->resistance <= 0 || zone->capacitance <= 0
+			|| !zone->trip_temp || zone->cdevs.empty()) {
+		thd_log_warn(
+				"simulator: zone needs Type, ThermalResistance, ThermalCapacitance, Temperature and a CoolingDevice\n");
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
+int cthd_simulator::parse_scenario(xmlNode *a_node, xmlDoc *doc) {
+	xmlNode *cur_node = nullptr;
+	char *tmp_value;
+
+	for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
+		if (cur_node->type != XML_ELEMENT_NODE)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Ambient")) {
+			if (parse_profile(cur_node->children, doc, ambient) != THD_SUCCESS)
+				return THD_ERROR;
+			continue;
+		}
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Zone")) {
+			sim_zone_t zone;
+
+			if (parse_zone(cur_node->children, doc, &zone) != THD_SUCCESS)
+				return THD_ERROR;
+			zones.push_back(zone);
+			continue;
+		}
+
+		tmp_value = (char*) xmlNodeListGetString(doc, cur_node->xmlChildrenNode,
+				1);
+		if (!tmp_value)
+			continue;
+
+		if (!thd_strcasecmp_n((const char*) cur_node->name, "Name"))
+			name.assign(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "Duration"))
+			duration = atoi(tmp_value) * 1000;
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "TimeStep"))
+			time_step = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name,
+				"SamplingPeriod"))
+			sample_period = atoi(tmp_value);
+		else if (!thd_strcasecmp_n((const char*) cur_node->name, "SettleBand"))
+			settle_band = atof(tmp_value);
+		xmlFree(tmp_value);
+	}
+
+	if (duration <= 0 || time_step <= 0 || sample_period <= 0
+			|| zones.empty()) {
+		thd_log_warn(
+				"simulator: scenario needs Duration, TimeStep, SamplingPeriod and a Zone\n");
+		return THD_ERROR;
+	}
+
+	return THD_SUCCESS;
+}
+
+int cthd_simulator::load(const std::string &path) {
+	xmlDoc *doc;
+	xmlNode *root_element;
+	int ret;
+
+	doc = xmlReadFile(path.c_str(), nullptr, 0);
+	if (doc == nullptr) {
+		thd_log_warn("error: could not parse file %s\n", path.c_str());
+		return THD_ERROR;
+	}
+
+	root_element = xmlDocGetRootElement(doc);
+	if (root_element == nullptr
+			|| thd_strcasecmp_n((const char*) root_element->name,
+					"ThermalSimulation")) {
+		thd_log_warn("error: %s is not a simulation scenario\n", path.c_str());
+		xmlFreeDoc(doc);
+		return THD_ERROR;
+	}
+
+	ret = parse_scenario(root_element->children, doc);
+	xmlFreeDoc(doc);
+	if (ret != THD_SUCCESS)
+		return ret;
+
+	if (name.empty())
+		name = path;
+
+	double ambient_temp = profile_value(ambient, 0, def_ambient_temp);
+	for (sim_zone_t &zone : zones) {
+		if (zone.initial_temp_valid)
+			zone.temp = zone.initial_temp;
+		else
+			zone.temp = ambient_temp
+					+ zone.resistance
+							* (zone.idle_power + profile_value(zone.load, 0, 0));
+		zone.demand_energy = 0;
+		zone.delivered_energy = 0;
+		zone.peak_temp = zone.temp;
+		zone.time_above_trip = 0;
+		zone.history.reserve(duration / time_step + 1);
+	}
+
+	return THD_SUCCESS;
+}
+
+void cthd_simulator::attach(std::vector<std::unique_ptr<cthd_sensor>> &sensors,
+		std::vector<std::unique_ptr<cthd_cdev>> &cdevs,
+		std::vector<std::unique_ptr<cthd_zone>> &zones) {
+	for (sim_zone_t &sim_zone : this->zones) {
+		cthd_sensor_sim *sensor = new cthd_sensor_sim(sensors.size(),
+				sim_zone.type);
+		sensors.push_back(std::unique_ptr<cthd_sensor>(sensor));
+		sim_zone.sensor = sensor;
+
+		cthd_trip_point trip(0, PASSIVE, sim_zone.trip_temp, sim_zone.hyst,
+				zones.size(), sensor->get_index(), sim_zone.control_type);
+
+		for (sim_cdev_t &sim_cdev : sim_zone.cdevs) {
+			cthd_cdev_sim *cdev = new cthd_cdev_sim(cdevs.size(), sim_cdev.type,
+					sim_cdev.max_state);
+			cdevs.push_back(std::unique_ptr<cthd_cdev>(cdev));
+			cdev->set_inc_dec_value(sim_cdev.inc_dec_step);
+			cdev->set_debounce_interval(sim_cdev.debounce_interval);
+			sim_cdev.cdev = cdev;
+
+			trip.thd_trip_point_add_cdev(*cdev, sim_cdev.influence, 0, 0,
+					TRIP_PT_INVALID_TARGET_STATE, &sim_cdev.pid);
+		}
+
+		cthd_zone_sim *zone = new cthd_zone_sim(zones.size(), sim_zone.type,
+				sensor, trip);
+		if (zone->zone_update() == THD_SUCCESS)
+			zone->set_zone_active();
+		zones.push_back(std::unique_ptr<cthd_zone>(zone));
+	}
+
+	update_sensors();
+}
+
+void cthd_simulator::update_sensors() {
+	for (sim_zone_t &zone : zones) {
+		double temp = zone.temp * 1000 + 0.5;
+
+		zone.sensor->set_plant_temp(temp > 0 ? (unsigned int) temp : 0);
+	}
+}
+
+// Fraction of the load which runs with the current cdev states
+double cthd_simulator::zone_performance(sim_zone_t &zone) {
+	double perf = 1.0;
+
+	for (sim_cdev_t &cdev : zone.cdevs) {
+		int state = cdev.cdev->get_curr_state();
+
+		if (state < 0)
+			state = 0;
+		if (state > cdev.max_state)
+			state = cdev.max_state;
+		perf *= 1.0 - cdev.power_reduction * state / cdev.max_state;
+
+		// A change of direction, counted as one oscillation
+		if (state != cdev.last_state) {
+			int direction = state > cdev.last_state ? 1 : -1;
+
+			if (cdev.last_direction && direction != cdev.last_direction)
+				cdev.reversals++;
+			cdev.last_direction = direction;
+			cdev.last_state = state;
+		}
+	}
+
+	return perf;
+}
+
+void cthd_simulator::step() {
+	double dt = time_step / 1000.0;
+	double now = elapsed / 1000.0;
+	double ambient_temp = profile_value(ambient, now, def_ambient_temp);
+
+	for (sim_zone_t &zone : zones) {
+		double load = profile_value(zone.load, now, 0);
+		double perf = zone_performance(zone);
+		double power = zone.idle_power + load * perf;
+
+		// Explicit Euler, stable with steps well below the time constant
+		double tau = zone.resistance * zone.capacitance;
+		int substeps = (int) ceil(dt * 20 / tau);
+		if (substeps < 1)
+			substeps = 1;
+		double h = dt / substeps;
+
+		for (int i = 0; i < substeps; ++i)
+			zone.temp += h
+					* (power - (zone.temp - ambient_temp) / zone.resistance)
+					/ zone.capacitance;
+
+		zone.demand_energy += load * dt;
+		zone.delivered_energy += load * perf * dt;
+		if (zone.temp > zone.peak_temp)
+			zone.peak_temp = zone.temp;
+		if (zone.temp * 1000 > zone.trip_temp)
+			zone.time_above_trip += dt;
+		zone.history.push_back((float) zone.temp);
+	}
+
+	elapsed += time_step;
+}
+
+/* Settling: time after the last change of the load or ambient profile,
+ * from which the temperature stays within settle_band of its final value.
+ * The final value is the average of the last 10% of the run, ripple is
+ * peak to peak temperature in it. Settling is -1 if the temperature is
+ * still outside of the band at the end.
+ */
+void cthd_simulator::zone_metrics(sim_zone_t &zone, double *settling,
+		double *ripple) {
+	unsigned int count = zone.history.size();
+	double dt = time_step / 1000.0;
+
+	*settling = -1;
+	*ripple = 0;
+	if (!count)
+		return;
+
+	unsigned int window = count / 10;
+	if (window < 1)
+		window = 1;
+
+	double sum = 0, min = zone.history[count - 1], max = min;
+	for (unsigned int i = count - window; i < count; ++i) {
+		sum += zone.history[i];
+		if (zone.history[i] < min)
+			min = zone.history[i];
+		if (zone.history[i] > max)
+			max = zone.history[i];
+	}
+	double final_temp = sum / window;
+	*ripple = max - min;
+
+	double change = std::max(profile_end(zone.load), profile_end(ambient));
+	double settled = change;
+	for (unsigned int i = 0; i < count; ++i) {
+		double time = (i + 1) * dt;
+
+		if (time >= change && fabs(zone.history[i] - final_temp) > settle_band)
+			settled = time + dt;
+	}
+
+	if (settled > count * dt)
+		return;
+
+	*settling = settled - change;
+}
+
+void cthd_simulator::report(FILE *out) {
+	fprintf(out, "scenario %s duration_s %.1f step_ms %d sample_ms %d\n",
+			name.c_str(), elapsed / 1000.0, time_step, sample_period);
+	fprintf(out,
+			"zone throughput_lost_pct peak_c overshoot_c time_above_trip_s settling_s ripple_c cdev_reversals\n");
+
+	for (sim_zone_t &zone : zones) {
+		double lost = 0, settling, ripple;
+		unsigned long reversals = 0;
+
+		if (zone.demand_energy > 0)
+			lost = 100.0 * (1.0 - zone.delivered_energy / zone.demand_energy);
+
+		double overshoot = zone.peak_temp - zone.trip_temp / 1000.0;
+		if (overshoot < 0)
+			overshoot = 0;
+
+		zone_metrics(zone, &settling, &ripple);
+		for (sim_cdev_t &cdev : zone.cdevs)
+			reversals += cdev.reversals;
+
+		fprintf(out, "%s %.2f %.2f %.2f %.1f %.1f %.2f %lu\n",
+				zone.type.c_str(), lost, zone.peak_temp, overshoot,
+				zone.time_above_trip, settling, ripple, reversals);
+	}
+}
+
+int thd_engine_create_simulator_engine(const char *scenario_file) {
+	cthd_simulator sim;
+	int res;
+
+	if (sim.load(scenario_file) != THD_SUCCESS)
+		return THD_ERROR;
+
+	// A bare engine: no platform detection, nothing from the running system
+	thd_engine.reset(new cthd_engine("simulator"));
+	if (!thd_engine)
+		return THD_ERROR;
+
+	res = thd_engine->thd_engine_simulate(sim);
+	if (res != THD_SUCCESS)
+		thd_log_msg("THD engine simulation failed\n");
+
+	return res;
+}
@@ -0,0 +1,202 @@
+/*
+ * thd_simulator.h: closed loop thermal plant simulator interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_SIMULATOR_H_
+#define THD_SIMULATOR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include "thd_sensor.h"
+#include "thd_cdev.h"
+#include "thd_zone.h"
+
+// Temperature of a simulated zone, read by the trip points as any sensor
+class cthd_sensor_sim: public cthd_sensor {
+private:
+	unsigned int plant_temp;
+
+public:
+	cthd_sensor_sim(int _index, std::string _type_str) :
+			cthd_sensor(_index, "", std::move(_type_str), SENSOR_TYPE_RAW), plant_temp(
+					0) {
+	}
+	void set_plant_temp(unsigned int temp) {
+		plant_temp = temp;
+	}
+	unsigned int read_temperature() override {
+		update_cached_temp(plant_temp);
+		return plant_temp;
+	}
+	int register_snapshot(csys_fs_snapshot *snap) override {
+		return -1;
+	}
+};
+
+// A state only limits the simulated load, nothing is written
+class cthd_cdev_sim: public cthd_cdev {
+public:
+	cthd_cdev_sim(unsigned int _index, std::string _type_str, int _max_state) :
+			cthd_cdev(_index, "") {
+		type_str = std::move(_type_str);
+		min_state = 0;
+		max_state = _max_state;
+		read_back = false;
+	}
+	void set_curr_state(int state, int arg) override {
+		curr_state = state;
+	}
+	int update() override {
+		return THD_SUCCESS;
+	}
+};
+
+// One PASSIVE trip on the zone sensor with all simulated cdevs of the zone
+class cthd_zone_sim: public cthd_zone {
+private:
+	cthd_sensor *sensor;
+	cthd_trip_point trip;
+
+public:
+	cthd_zone_sim(int _index, std::string _type_str, cthd_sensor *_sensor,
+			cthd_trip_point _trip) :
+			cthd_zone(_index, ""), sensor(_sensor), trip(std::move(_trip)) {
+		type_str = std::move(_type_str);
+	}
+	int read_trip_points() override {
+		trip_points.push_back(trip);
+		return THD_SUCCESS;
+	}
+	int read_cdev_trip_points() override {
+		return THD_SUCCESS;
+	}
+	int zone_bind_sensors() override {
+		bind_sensor(sensor);
+		return THD_SUCCESS;
+	}
+};
+
+/* Lumped RC model of a platform: each zone is one thermal node with
+ * C dT/dt = P - (T - T_ambient) / R
+ * P is the idle power plus the scenario load, of which each cooling device
+ * of the zone removes PowerReduction * state / MaxState. Time is virtual,
+ * so the real trip point, exponential and PID controllers run closed loop
+ * against the model as fast as the CPU allows.
+ */
+class cthd_simulator {
+private:
+	typedef struct {
+		double time; // sec
+		double value;
+	} profile_point_t;
+
+	typedef struct {
+		std::string type;
+		int max_state;
+		double power_reduction;
+		int inc_dec_step;
+		int debounce_interval;
+		int influence;
+		pid_param_t pid;
+		cthd_cdev_sim *cdev;
+		int last_state;
+		int last_direction;
+		unsigned long reversals;
+	} sim_cdev_t;
+
+	typedef struct {
+		std::string type;
+		double resistance; // C/W
+		double capacitance; // J/C
+		double idle_power; // W
+		bool initial_temp_valid;
+		double initial_temp; // C, else steady state at time 0
+		unsigned int trip_temp; // mC
+		unsigned int hyst; // mC
+		trip_control_type_t control_type;
+		std::vector<profile_point_t> load;
+		std::vector<sim_cdev_t> cdevs;
+		cthd_sensor_sim *sensor;
+		double temp;
+		// Metrics
+		double demand_energy;
+		double delivered_energy;
+		double peak_temp;
+		double time_above_trip;
+		std::vector<float> history;
+	} sim_zone_t;
+
+	std::string name;
+	int duration; // msec
+	int time_step; // msec
+	int sample_period; // msec
+	double settle_band; // C
+	std::vector<profile_point_t> ambient;
+	std::vector<sim_zone_t> zones;
+	long long elapsed; // msec
+
+	static double profile_value(const std::vector<profile_point_t> &profile,
+			double time, double def);
+	static double profile_end(const std::vector<profile_point_t> &profile);
+	int parse_profile(xmlNode *a_node, xmlDoc *doc,
+			std::vector<profile_point_t> &profile);
+	int parse_cdev(xmlNode *a_node, xmlDoc *doc, sim_cdev_t *cdev);
+	int parse_zone(xmlNode *a_node, xmlDoc *doc, sim_zone_t *zone);
+	int parse_scenario(xmlNode *a_node, xmlDoc *doc);
+	double zone_performance(sim_zone_t &zone);
+	void zone_metrics(sim_zone_t &zone, double *settling, double *ripple);
+
+public:
+	cthd_simulator();
+
+	int load(const std::string &path);
+	// Create the simulated objects and hand them over to the engine
+	void attach(std::vector<std::unique_ptr<cthd_sensor>> &sensors,
+			std::vector<std::unique_ptr<cthd_cdev>> &cdevs,
+			std::vector<std::unique_ptr<cthd_zone>> &zones);
+	// Publish plant temperatures to the sensors
+	void update_sensors();
+	// Advance the plant by one time step with current cdev states
+	void step();
+	void report(FILE *out);
+
+	int get_duration() {
+		return duration;
+	}
+	int get_time_step() {
+		return time_step;
+	}
+	int get_sample_period() {
+		return sample_period;
+	}
+	long long get_elapsed() {
+		return elapsed;
+	}
+};
+
+int thd_engine_create_simulator_engine(const char *scenario_file);
+
+#endif /* THD_SIMULATOR_H_ */
@@ -24,6 +24,7 @@
 
 #include "thd_sys_fs.h"
 #include "thd_common.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <vector>
 
@@ -58,9 +59,36 @@ int csys_fs::check_non_symbolic_path(const std::string& path)
 	return THD_SUCCESS;
 }
 
+bool csys_fs::dry_run = false;
+std::string csys_fs::root;
+
+void csys_fs::set_root(std::string _root) {
+	while (!_root.empty() && _root.back() == '/')
+		_root.pop_back();
+	root = std::move(_root);
+}
+
+std::string csys_fs::map_path(std::string path) {
+	if (root.empty())
+		return path;
+
+	// TDRUNDIR too, so the files of the system instance are left alone
+	if (!path.compare(0, 5, "/sys/")
+			|| !path.compare(0, sizeof(TDRUNDIR), TDRUNDIR "/"))
+		return root + path;
+
+	return path;
+}
+
 int csys_fs::write(const std::string &path, const std::string &buf) {
-	std::string p = base_path + path;
-	int fd = ::open(p.c_str(), O_WRONLY | O_NOFOLLOW);
+	std::string p = map_path(base_path + path);
+	if (dry_run) {
+		thd_log_debug("dry run write %s:%s\n", p.c_str(), buf.c_str());
+		return buf.size();
+	}
+	// A generated tree has regular files, don't leave a longer old value
+	int flags = root.empty() ? O_WRONLY : O_WRONLY | O_TRUNC;
+	int fd = ::open(p.c_str(), flags | O_NOFOLLOW);
 	if (fd < 0) {
 		thd_log_info("sysfs write failed %s\n", p.c_str());
 		return -errno;
@@ -77,7 +105,11 @@ int csys_fs::write(const std::string &path, const std::string &buf) {
 
 int csys_fs::write(const std::string &path, unsigned int position, unsigned
 long long data) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
+	if (dry_run) {
+		thd_log_debug("dry run write %s:%u:%llu\n", p.c_str(), position, data);
+		return sizeof(data);
+	}
 	int fd = ::open(p.c_str(), O_WRONLY | O_NOFOLLOW);
 	if (fd < 0) {
 		thd_log_info("sysfs write failed %s\n", p.c_str());
@@ -106,7 +138,7 @@ int csys_fs::read(const std::string &path, char *buf, int len) {
 	if (!buf)
 		return -EINVAL;
 
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	int fd = get_cached_fd(p);
 	size_t curr_len = len;
 	off_t offset = 0;
@@ -130,7 +162,7 @@ int csys_fs::read(const std::string &path, char *buf, int len) {
 
 int csys_fs::read(const std::string &path, unsigned int position, char *buf,
 		int len) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	int fd = get_cached_fd(p);
 	if (fd < 0) {
 		thd_log_info("sysfs read failed %s\n", p.c_str());
@@ -144,7 +176,7 @@ int csys_fs::read(const std::string &path, unsigned int position, char *buf,
 }
 
 int csys_fs::read(const std::string &path, int *ptr_val) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	char str[16];
 
 	int fd = get_cached_fd(p);
@@ -163,7 +195,7 @@ int csys_fs::read(const std::string &path, int *ptr_val) {
 }
 
 int csys_fs::read(const std::string &path, unsigned long *ptr_val) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	char str[32];
 
 	int fd = get_cached_fd(p);
@@ -182,7 +214,7 @@ int csys_fs::read(const std::string &path, unsigned long *ptr_val) {
 }
 
 int csys_fs::read(const std::string &path, std::string &buf) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	int ret = 0;
 
 #ifndef ANDROID
@@ -219,13 +251,13 @@ int csys_fs::read(const std::string &path, std::string &buf) {
 bool csys_fs::exists(const std::string &path) {
 	struct stat s;
 
-	return (bool) (stat((base_path + path).c_str(), &s) == 0);
+	return (bool) (stat(map_path(base_path + path).c_str(), &s) == 0);
 }
 
 size_t csys_fs::size(const std::string &path) {
 	struct stat s;
 
-	if (stat((base_path + path).c_str(), &s) == 0)
+	if (stat(map_path(base_path + path).c_str(), &s) == 0)
 		return s.st_size;
 
 	return 0;
@@ -278,15 +310,173 @@ bool csys_fs::exists() {
 mode_t csys_fs::get_mode(const std::string &path) {
 	struct stat s;
 
-	if (stat((base_path + path).c_str(), &s) == 0)
+	if (stat(map_path(base_path + path).c_str(), &s) == 0)
 		return s.st_mode;
 	else
 		return 0;
 }
 
+int csys_fs_attr::open(const std::string &_path, int flags) {
+	close();
+	path = _path;
+	fd = ::open(csys_fs::map_path(path).c_str(),
+			flags | O_NOFOLLOW | O_CLOEXEC);
+	if (fd < 0) {
+		thd_log_info("sysfs open failed %s\n", path.c_str());
+		return -errno;
+	}
+
+	return THD_SUCCESS;
+}
+
+void csys_fs_attr::close() {
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+}
+
+int csys_fs_attr::read(int *ptr_val) {
+	int ret = ::pread(fd, buf, sizeof(buf) - 1, 0);
+	if (ret > 0) {
+		buf[ret] = '\0';
+		*ptr_val = atoi(buf);
+	} else
+		thd_log_info("sysfs read failed %s\n", path.c_str());
+
+	return ret;
+}
+
+int csys_fs_attr::read(unsigned long *ptr_val) {
+	int ret = ::pread(fd, buf, sizeof(buf) - 1, 0);
+	if (ret > 0) {
+		buf[ret] = '\0';
+		*ptr_val = atol(buf);
+	} else
+		thd_log_info("sysfs read failed %s\n", path.c_str());
+
+	return ret;
+}
+
+int csys_fs_attr::write(long long data) {
+	int len = snprintf(buf, sizeof(buf), "%lld", data);
+	if (csys_fs::is_dry_run()) {
+		thd_log_debug("dry run write %s:%s\n", path.c_str(), buf);
+		return len;
+	}
+	int ret = ::pwrite(fd, buf, len, 0);
+	if (ret < 0) {
+		ret = -errno;
+		thd_log_info("sysfs write failed %s\n", path.c_str());
+	} else if (!csys_fs::get_root().empty() && ftruncate(fd, len) < 0) {
+		// A generated tree has regular files, drop a longer old value
+		thd_log_info("sysfs truncate failed %s\n", path.c_str());
+	}
+
+	return ret;
+}
+
+csys_fs_snapshot::~csys_fs_snapshot() {
+	for (auto &attr : attrs) {
+		if (attr.fd >= 0)
+			close(attr.fd);
+	}
+}
+
+int csys_fs_snapshot::add(const std::string &path) {
+	snapshot_attr_t attr;
+
+	attr.fd = ::open(csys_fs::map_path(path).c_str(), O_RDONLY | O_NOFOLLOW);
+	if (attr.fd < 0) {
+		thd_log_info("sysfs snapshot open failed %s\n", path.c_str());
+		return -errno;
+	}
+	attr.path = path;
+	attr.valid = false;
+	attr.value = 0;
+
+	for (unsigned int i = 0; i < attrs.size(); ++i) {
+		if (attrs[i].fd < 0) {
+			attrs[i] = attr;
+			return i;
+		}
+	}
+	attrs.push_back(attr);
+
+	return attrs.size() - 1;
+}
+
+void csys_fs_snapshot::remove(int slot) {
+	if (slot < 0 || slot >= (int) attrs.size() || attrs[slot].fd < 0)
+		return;
+
+	close(attrs[slot].fd);
+	attrs[slot].fd = -1;
+	attrs[slot].path.clear();
+	attrs[slot].valid = false;
+}
+
+int csys_fs_snapshot::read_attr(snapshot_attr_t &attr) {
+	char str[32];
+
+	int ret = ::pread(attr.fd, str, sizeof(str) - 1, 0);
+	if (ret <= 0) {
+		thd_log_info("sysfs snapshot read failed %s\n", attr.path.c_str());
+		attr.valid = false;
+		return THD_ERROR;
+	}
+	str[ret] = '\0';
+	attr.value = strtoll(str, nullptr, 10);
+	attr.valid = true;
+
+	return THD_SUCCESS;
+}
+
+int csys_fs_snapshot::refresh() {
+	int failed = 0;
+
+	for (auto &attr : attrs) {
+		if (attr.fd < 0)
+			continue;
+		if (read_attr(attr) != THD_SUCCESS)
+			++failed;
+	}
+
+	return failed;
+}
+
+int csys_fs_snapshot::refresh(const std::vector<int> &slots) {
+	int failed = 0;
+
+	for (int slot : slots) {
+		if (slot < 0 || slot >= (int) attrs.size())
+			continue;
+		// Same attribute can be listed more than once
+		if (attrs[slot].valid || attrs[slot].fd < 0)
+			continue;
+		if (read_attr(attrs[slot]) != THD_SUCCESS)
+			++failed;
+	}
+
+	return failed;
+}
+
+void csys_fs_snapshot::invalidate() {
+	for (auto &attr : attrs)
+		attr.valid = false;
+}
+
+int csys_fs_snapshot::get(int slot, long long *value) {
+	if (slot < 0 || slot >= (int) attrs.size() || !attrs[slot].valid)
+		return THD_ERROR;
+
+	*value = attrs[slot].value;
+
+	return THD_SUCCESS;
+}
+
 int csys_fs::read_symbolic_link_value(const std::string &path, char *buf,
 		int len) {
-	std::string p = base_path + path;
+	std::string p = map_path(base_path + path);
 	int ret = ::readlink(p.c_str(), buf, len);
 	if (ret < 0) {
 		*buf = '\0';
@@ -35,11 +35,14 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class csys_fs {
 private:
 	std::string base_path;
 	std::unordered_map<std::string, int> fd_cache;
+	static bool dry_run;
+	static std::string root;
 
 	int get_cached_fd(const std::string &full_path);
 
@@ -86,6 +89,93 @@ public:
 	void update_path(std::string path) {
 		base_path = std::move(path);
 	}
+
+	// Writes are dropped and reported as done, used by replay
+	static void set_dry_run(bool enable) {
+		dry_run = enable;
+	}
+	static bool is_dry_run() {
+		return dry_run;
+	}
+
+	// Paths under /sys/ and TDRUNDIR are looked up below this directory,
+	// used to run against a generated tree
+	static void set_root(std::string _root);
+	static const std::string& get_root() {
+		return root;
+	}
+	static std::string map_path(std::string path);
+};
+
+// Pre-resolved attribute: the path is built and the file is opened once,
+// so reads and writes on the sampling path don't allocate or hash.
+class csys_fs_attr {
+private:
+	std::string path;
+	int fd;
+	char buf[32];
+
+public:
+	csys_fs_attr() :
+			path(""), fd(-1) {
+		buf[0] = '\0';
+	}
+	~csys_fs_attr() {
+		close();
+	}
+	csys_fs_attr(const csys_fs_attr &) = delete;
+	csys_fs_attr &operator=(const csys_fs_attr &) = delete;
+
+	int open(const std::string &_path, int flags = O_RDONLY);
+	void close();
+	bool is_open() {
+		return fd >= 0;
+	}
+	const std::string& get_path() {
+		return path;
+	}
+
+	int read(int *ptr_val);
+	int read(unsigned long *ptr_val);
+	int write(long long data);
+};
+
+// Set of integer attributes registered once and read together. The files
+// are kept open, so a refresh is one pread() per attribute without any path
+// building or fd cache lookup. Values are valid from refresh() to invalidate().
+class csys_fs_snapshot {
+private:
+	typedef struct {
+		std::string path;
+		int fd;
+		bool valid;
+		long long value;
+	} snapshot_attr_t;
+
+	std::vector<snapshot_attr_t> attrs;
+
+	int read_attr(snapshot_attr_t &attr);
+
+public:
+	csys_fs_snapshot() {
+	}
+	~csys_fs_snapshot();
+	csys_fs_snapshot(const csys_fs_snapshot &) = delete;
+	csys_fs_snapshot &operator=(const csys_fs_snapshot &) = delete;
+
+	/* register full path, returns slot index or negative error */
+	int add(const std::string &path);
+	/* close the slot, a later add reuses it */
+	void remove(int slot);
+	/* read all or only the listed slots, returns number of failures */
+	int refresh();
+	int refresh(const std::vector<int> &slots);
+	void invalidate();
+	int get(int slot, long long *value);
+
+	int size() {
+		return attrs.size();
+	}
 };
 
 #endif /* THD_SYS_FS_H_ */
@@ -0,0 +1,243 @@
+/*
+ * thd_telemetry.cpp: shared memory telemetry implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Telemetry for local agents sampling faster than D-Bus allows. Every engine
+ * snapshot is copied to a file under TDRUNDIR, which is mapped shared and
+ * pre-faulted at open. A reader maps the file, then copies what it needs
+ * between two reads of the header seq, retrying when seq was odd or changed.
+ * Names are only rewritten when the snapshot layout changes, readers cache
+ * them until layout_seq changes. A restart replaces the file, a reader
+ * notices by its magic or by seq no longer changing.
+ */
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "thd_common.h"
+#include "thd_telemetry.h"
+
+static constexpr size_t telemetry_header_size = 4096;
+
+static const domain_type telemetry_rapl_domains[RAPL_DOMAIN_TYPES] = {
+		PACKAGE, DRAM, CORE, UNCORE };
+
+static size_t telemetry_align(size_t offset) {
+	return (offset + 63) & ~((size_t) 63);
+}
+
+cthd_telemetry::cthd_telemetry() :
+		map(nullptr), map_size(0), header(nullptr), sensor_temps(nullptr), zone_temps(
+				nullptr), cdev_states(nullptr), rapl_power(nullptr), sensor_names(
+				nullptr), zone_names(nullptr), cdev_names(nullptr) {
+}
+
+cthd_telemetry::~cthd_telemetry() {
+	close();
+}
+
+int cthd_telemetry::open(const std::string &path) {
+	std::string tmp_path = path + ".tmp";
+	size_t offset;
+	int fd;
+
+	if (map)
+		return THD_SUCCESS;
+
+	// Readers of a previous file keep their mapping, so never truncate it
+	fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+			0644);
+	if (fd < 0) {
+		thd_log_warn("Can't create telemetry file %s: %s\n", tmp_path.c_str(),
+				strerror(errno));
+		return THD_ERROR;
+	}
+
+	offset = telemetry_header_size;
+	size_t sensor_temps_offset = offset;
+	offset = telemetry_align(offset + max_sensors * sizeof(int32_t));
+	size_t zone_temps_offset = offset;
+	offset = telemetry_align(offset + max_zones * sizeof(int32_t));
+	size_t cdev_states_offset = offset;
+	offset = telemetry_align(offset + max_cdevs * sizeof(int32_t));
+	size_t rapl_power_offset = offset;
+	offset = telemetry_align(offset + RAPL_DOMAIN_TYPES * sizeof(uint32_t));
+	size_t sensor_names_offset = offset;
+	offset += max_sensors * name_size;
+	size_t zone_names_offset = offset;
+	offset += max_zones * name_size;
+	size_t cdev_names_offset = offset;
+	offset += max_cdevs * name_size;
+	map_size = offset;
+
+	if (ftruncate(fd, map_size) < 0) {
+		thd_log_warn("Can't size telemetry file %s: %s\n", tmp_path.c_str(),
+				strerror(errno));
+		::close(fd);
+		unlink(tmp_path.c_str());
+		return THD_ERROR;
+	}
+
+	map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		thd_log_warn("Can't map telemetry file %s: %s\n", tmp_path.c_str(),
+				strerror(errno));
+		map = nullptr;
+		unlink(tmp_path.c_str());
+		return THD_ERROR;
+	}
+
+	memset(map, 0, map_size);
+
+	header = (thd_telemetry_header_t *) map;
+	sensor_temps = (int32_t *) ((char *) map + sensor_temps_offset);
+	zone_temps = (int32_t *) ((char *) map + zone_temps_offset);
+	cdev_states = (int32_t *) ((char *) map + cdev_states_offset);
+	rapl_power = (uint32_t *) ((char *) map + rapl_power_offset);
+	sensor_names = (char *) map + sensor_names_offset;
+	zone_names = (char *) map + zone_names_offset;
+	cdev_names = (char *) map + cdev_names_offset;
+
+	header->version = telemetry_version;
+	header->name_size = name_size;
+	header->max_sensors = max_sensors;
+	header->max_zones = max_zones;
+	header->max_cdevs = max_cdevs;
+	header->rapl_domains = RAPL_DOMAIN_TYPES;
+	header->sensor_temps_offset = sensor_temps_offset;
+	header->zone_temps_offset = zone_temps_offset;
+	header->cdev_states_offset = cdev_states_offset;
+	header->rapl_power_offset = rapl_power_offset;
+	header->sensor_names_offset = sensor_names_offset;
+	header->zone_names_offset = zone_names_offset;
+	header->cdev_names_offset = cdev_names_offset;
+	header->seq.store(0, std::memory_order_relaxed);
+	// Readers check the magic last
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header->magic, "THDTELEM", sizeof(header->magic));
+
+	if (rename(tmp_path.c_str(), path.c_str())) {
+		thd_log_warn("Can't rename telemetry file %s: %s\n", path.c_str(),
+				strerror(errno));
+		unlink(tmp_path.c_str());
+		close();
+		return THD_ERROR;
+	}
+
+	layout.reset();
+	thd_log_info("Telemetry file %s\n", path.c_str());
+
+	return THD_SUCCESS;
+}
+
+void cthd_telemetry::close() {
+	if (!map)
+		return;
+
+	munmap(map, map_size);
+	map = nullptr;
+	header = nullptr;
+	layout.reset();
+}
+
+static void telemetry_write_name(char *names, unsigned int index,
+		unsigned int size, const std::string &name) {
+	char *entry = names + index * size;
+
+	memset(entry, 0, size);
+	strncpy(entry, name.c_str(), size - 1);
+}
+
+// Called inside the seqlock write section
+void cthd_telemetry::write_layout(const cthd_snapshot_layout &new_layout) {
+	uint32_t sensor_count = std::min((size_t) max_sensors,
+			new_layout.sensors.size());
+	uint32_t zone_count = std::min((size_t) max_zones,
+			new_layout.zones.size());
+	uint32_t cdev_count = std::min((size_t) max_cdevs,
+			new_layout.cdevs.size());
+
+	if (sensor_count < new_layout.sensors.size()
+			|| zone_count < new_layout.zones.size()
+			|| cdev_count < new_layout.cdevs.size())
+		thd_log_info("Telemetry limited to %u sensors %u zones %u cdevs\n",
+				max_sensors, max_zones, max_cdevs);
+
+	for (uint32_t i = 0; i < sensor_count; ++i)
+		telemetry_write_name(sensor_names, i, name_size,
+				new_layout.sensors[i].type);
+	for (uint32_t i = 0; i < zone_count; ++i)
+		telemetry_write_name(zone_names, i, name_size,
+				new_layout.zones[i].type);
+	for (uint32_t i = 0; i < cdev_count; ++i)
+		telemetry_write_name(cdev_names, i, name_size,
+				new_layout.cdevs[i].type);
+
+	header->sensor_count = sensor_count;
+	header->zone_count = zone_count;
+	header->cdev_count = cdev_count;
+	header->layout_seq++;
+}
+
+// Hot path: memory stores only, no system call
+void cthd_telemetry::publish(const cthd_engine_snapshot &snap,
+		cthd_rapl_power_meter &rapl_power_meter) {
+	unsigned int power[RAPL_DOMAIN_TYPES];
+
+	if (!map)
+		return;
+
+	// Outside of the write section, it has a seqlock of its own
+	for (int i = 0; i < RAPL_DOMAIN_TYPES; ++i) {
+		rapl_power_snapshot_t rapl;
+
+		if (rapl_power_meter.rapl_get_power_snapshot(telemetry_rapl_domains[i],
+				&rapl))
+			power[i] = rapl.power;
+		else
+			power[i] = 0;
+	}
+
+	uint64_t seq = header->seq.load(std::memory_order_relaxed);
+	header->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (layout != snap.layout) {
+		write_layout(*snap.layout);
+		layout = snap.layout;
+	}
+
+	header->tick = snap.seq;
+	header->time_ms = snap.time;
+	for (uint32_t i = 0; i < header->sensor_count; ++i)
+		sensor_temps[i] = snap.sensor_temps[i];
+	for (uint32_t i = 0; i < header->zone_count; ++i)
+		zone_temps[i] = snap.zone_temps[i];
+	for (uint32_t i = 0; i < header->cdev_count; ++i)
+		cdev_states[i] = snap.cdev_states[i];
+	memcpy(rapl_power, power, sizeof(power));
+
+	header->seq.store(seq + 2, std::memory_order_release);
+}
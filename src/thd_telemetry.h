@@ -0,0 +1,106 @@
+/*
+ * thd_telemetry.h: shared memory telemetry interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_TELEMETRY_H_
+#define THD_TELEMETRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "thd_engine_snapshot.h"
+#include "thd_rapl_power_meter.h"
+
+// The file layout is read by test/thermald_telemetry_reader.py, bump
+// telemetry_version on any change. Temperatures are in mC, power in uW.
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t name_size;
+	uint32_t max_sensors;
+	uint32_t max_zones;
+	uint32_t max_cdevs;
+	uint32_t rapl_domains;
+	uint64_t sensor_temps_offset;	// int32_t[max_sensors]
+	uint64_t zone_temps_offset;		// int32_t[max_zones]
+	uint64_t cdev_states_offset;	// int32_t[max_cdevs]
+	uint64_t rapl_power_offset;		// uint32_t[rapl_domains], 0: no reading
+	uint64_t sensor_names_offset;	// char[max_sensors][name_size]
+	uint64_t zone_names_offset;		// char[max_zones][name_size]
+	uint64_t cdev_names_offset;		// char[max_cdevs][name_size]
+	// Seqlock: odd while the fields below or any array is updated
+	std::atomic<uint64_t> seq;
+	uint64_t layout_seq;	// Changes with the counts and names
+	uint64_t tick;			// Engine snapshot sequence number
+	int64_t time_ms;		// CLOCK_MONOTONIC of the tick
+	uint32_t sensor_count;
+	uint32_t zone_count;
+	uint32_t cdev_count;
+	uint32_t reserved;
+} thd_telemetry_header_t;
+
+// Current values of the engine snapshot in a file mapped with MAP_SHARED,
+// as a struct of arrays indexed as the D-Bus sensor, zone and cdev indexes.
+// Local readers map it read only and poll without any system call.
+class cthd_telemetry {
+public:
+	static constexpr uint32_t telemetry_version = 1;
+
+private:
+	static constexpr uint32_t max_sensors = 1024;
+	static constexpr uint32_t max_zones = 256;
+	static constexpr uint32_t max_cdevs = 512;
+	static constexpr uint32_t name_size = 32;
+
+	void *map;
+	size_t map_size;
+	thd_telemetry_header_t *header;
+	int32_t *sensor_temps;
+	int32_t *zone_temps;
+	int32_t *cdev_states;
+	uint32_t *rapl_power;
+	char *sensor_names;
+	char *zone_names;
+	char *cdev_names;
+	// Layout the names were written from
+	std::shared_ptr<const cthd_snapshot_layout> layout;
+
+	void write_layout(const cthd_snapshot_layout &new_layout);
+
+public:
+	cthd_telemetry();
+	~cthd_telemetry();
+
+	int open(const std::string &path);
+	void close();
+	bool is_open() {
+		return map != nullptr;
+	}
+
+	// Single writer, called with the engine lock held
+	void publish(const cthd_engine_snapshot &snap,
+			cthd_rapl_power_meter &rapl_power_meter);
+};
+
+#endif /* THD_TELEMETRY_H_ */
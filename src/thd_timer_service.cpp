@@ -0,0 +1,184 @@
+/*
+ * thd_timer_service.cpp: shared timer service implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Periodic work other than zone sampling (RAPL energy counters, virtual
+ * sensors, engine state updates) used to run from own threads sleeping
+ * independently. They register here instead and the engine arms its
+ * timer_fd for the earliest deadline + slack. On each wakeup every timer
+ * past its deadline fires, which coalesces wakeups of close timers. There
+ * are only a handful of timers, so a linear scan is used instead of a heap.
+ */
+
+#include "thd_common.h"
+#include "thd_timer_service.h"
+
+cthd_timer_service::cthd_timer_service() :
+		next_id(0), latency_max(0), latency_total(0), fired_count(0) {
+}
+
+cthd_timer_service::timer_entry_t *cthd_timer_service::find_timer(int id) {
+	for (unsigned int i = 0; i < timers.size(); ++i) {
+		if (timers[i].id == id)
+			return &timers[i];
+	}
+
+	return nullptr;
+}
+
+long long cthd_timer_service::get_next_deadline() {
+	std::lock_guard<std::mutex> guard(timer_lock);
+	long long next = -1;
+
+	for (unsigned int i = 0; i < timers.size(); ++i) {
+		if (timers[i].deadline < 0)
+			continue;
+
+		long long latest = timers[i].deadline + timers[i].slack;
+		if (next < 0 || latest < next)
+			next = latest;
+	}
+
+	return next;
+}
+
+int cthd_timer_service::add_timer(long long deadline, int slack,
+		timer_callback_t callback) {
+	timer_entry_t timer;
+	long long next = get_next_deadline();
+	int id;
+
+	{
+		std::lock_guard<std::mutex> guard(timer_lock);
+
+		id = next_id++;
+		timer.id = id;
+		timer.deadline = deadline;
+		timer.slack = slack;
+		timer.callback = std::move(callback);
+		timers.push_back(std::move(timer));
+	}
+
+	if (deadline >= 0 && (next < 0 || deadline + slack < next) && wakeup)
+		wakeup();
+
+	return id;
+}
+
+void cthd_timer_service::remove_timer(int id) {
+	std::lock_guard<std::mutex> guard(timer_lock);
+
+	for (unsigned int i = 0; i < timers.size(); ++i) {
+		if (timers[i].id == id) {
+			timers.erase(timers.begin() + i);
+			break;
+		}
+	}
+}
+
+// Move the deadline of a timer, -1 disarms it
+void cthd_timer_service::set_deadline(int id, long long deadline) {
+	long long next = get_next_deadline();
+	bool earlier = false;
+
+	{
+		std::lock_guard<std::mutex> guard(timer_lock);
+		timer_entry_t *timer = find_timer(id);
+
+		if (!timer || timer->deadline == deadline)
+			return;
+
+		timer->deadline = deadline;
+		earlier = deadline >= 0 && (next < 0 || deadline + timer->slack < next);
+	}
+
+	if (earlier && wakeup)
+		wakeup();
+}
+
+// Fire all timers whose deadline expired, return the count
+int cthd_timer_service::run(long long now) {
+	{
+		std::lock_guard<std::mutex> guard(timer_lock);
+
+		due.clear();
+		for (unsigned int i = 0; i < timers.size(); ++i) {
+			timer_entry_t &timer = timers[i];
+
+			if (timer.deadline < 0 || timer.deadline > now)
+				continue;
+
+			// Firing within the slack is expected, count what is beyond.
+			// Deadline 0 runs on the next wakeup, that is never late.
+			if (timer.deadline > 0) {
+				long long late = now - timer.deadline - timer.slack;
+				if (late < 0)
+					late = 0;
+				if (late > latency_max)
+					latency_max = late;
+				latency_total += late;
+				++fired_count;
+			}
+
+			due.push_back(timer);
+			timer.deadline = -1;
+		}
+	}
+
+	// Callbacks may take the engine lock or arm other timers
+	for (unsigned int i = 0; i < due.size(); ++i) {
+		long long next = due[i].callback(due[i].deadline, now);
+
+		std::lock_guard<std::mutex> guard(timer_lock);
+		timer_entry_t *timer = find_timer(due[i].id);
+		if (!timer)
+			continue;
+
+		// Keep a deadline set from the callback, if that is earlier
+		if (timer->deadline < 0 || (next >= 0 && next < timer->deadline))
+			timer->deadline = next;
+	}
+
+	return due.size();
+}
+
+// Next deadline of a periodic timer, one interval after the deadline which
+// fired. Periods missed while the engine was busy are skipped.
+long long cthd_timer_service::next_period(long long deadline, long long now,
+		long long interval) {
+	long long next = deadline + interval;
+
+	if (next <= now)
+		next += ((now - next) / interval + 1) * interval;
+
+	return next;
+}
+
+void cthd_timer_service::get_latency(long long *max, long long *avg,
+		unsigned long *count) {
+	std::lock_guard<std::mutex> guard(timer_lock);
+
+	*max = latency_max;
+	*avg = fired_count ? latency_total / (long long) fired_count : 0;
+	*count = fired_count;
+}
@@ -0,0 +1,83 @@
+/*
+ * thd_timer_service.h: shared timer service interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+#ifndef THD_TIMER_SERVICE_H_
+#define THD_TIMER_SERVICE_H_
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Timers run from the engine thread, which sleeps until get_next_deadline().
+// Times are monotonic msec. A timer may fire up to slack msec after its
+// deadline, so that timers with close deadlines share one wakeup.
+class cthd_timer_service {
+public:
+	// Called with the deadline which fired, return the next deadline, -1 to
+	// stay disarmed. Periodic timers use next_period() so they don't drift
+	// by the slack.
+	typedef std::function<long long(long long deadline, long long now)>
+			timer_callback_t;
+
+private:
+	typedef struct {
+		int id;
+		long long deadline;
+		int slack;
+		timer_callback_t callback;
+	} timer_entry_t;
+
+	std::mutex timer_lock;
+	std::vector<timer_entry_t> timers;
+	std::vector<timer_entry_t> due;
+	int next_id;
+	std::function<void()> wakeup;
+
+	// Lateness of fired timers from their deadline
+	long long latency_max;
+	long long latency_total;
+	unsigned long fired_count;
+
+	timer_entry_t *find_timer(int id);
+
+public:
+	cthd_timer_service();
+
+	int add_timer(long long deadline, int slack, timer_callback_t callback);
+	void remove_timer(int id);
+	void set_deadline(int id, long long deadline);
+	long long get_next_deadline();
+	int run(long long now);
+	void get_latency(long long *max, long long *avg, unsigned long *count);
+
+	static long long next_period(long long deadline, long long now,
+			long long interval);
+
+	// Called when a timer is armed earlier than the current wakeup
+	void set_wakeup(std::function<void()> _wakeup) {
+		wakeup = std::move(_wakeup);
+	}
+};
+
+#endif /* THD_TIMER_SERVICE_H_ */
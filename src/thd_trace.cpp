@@ -0,0 +1,256 @@
+/*
+ * thd_trace.cpp: flight recorder implementation
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+
+/* Flight recorder for debugging throttling after the fact. Every sensor
+ * sample, trip transition, cooling device state change and RAPL power
+ * reading is stored as a 32 byte record in a circular area of a file under
+ * TDRUNDIR. The file is mapped shared and pre-faulted at open, so recording
+ * costs a fetch_add and a few stores, without any system call. The previous
+ * trace is kept with a ".old" suffix over a restart. Names of sensors, zones
+ * and cooling devices are stored in a separate table, updated when the
+ * engine rebuilds its sampling schedule.
+ */
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "thd_common.h"
+#include "thd_trace.h"
+#include "thd_util.h"
+
+static constexpr size_t trace_header_size = 4096;
+
+cthd_trace::cthd_trace() :
+		map(nullptr), map_size(0), header(nullptr), names(nullptr), records(
+				nullptr), names_used(0) {
+}
+
+cthd_trace::~cthd_trace() {
+	close();
+}
+
+int cthd_trace::open(const std::string &path) {
+	struct timespec real, mono;
+	int fd;
+
+	if (map)
+		return THD_SUCCESS;
+
+	if (rename(path.c_str(), (path + ".old").c_str()) && errno != ENOENT)
+		thd_log_info("Can't keep previous trace %s: %s\n", path.c_str(),
+				strerror(errno));
+
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		thd_log_warn("Can't create trace file %s: %s\n", path.c_str(),
+				strerror(errno));
+		return THD_ERROR;
+	}
+
+	map_size = trace_header_size + name_count * sizeof(thd_trace_name_t)
+			+ record_count * sizeof(thd_trace_record_t);
+	if (ftruncate(fd, map_size) < 0) {
+		thd_log_warn("Can't size trace file %s: %s\n", path.c_str(),
+				strerror(errno));
+		::close(fd);
+		return THD_ERROR;
+	}
+
+	map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		thd_log_warn("Can't map trace file %s: %s\n", path.c_str(),
+				strerror(errno));
+		map = nullptr;
+		return THD_ERROR;
+	}
+
+	// Fault in all pages now, not on the first record to each page
+	memset(map, 0, map_size);
+
+	header = (thd_trace_header_t *) map;
+	names = (thd_trace_name_t *) ((char *) map + trace_header_size);
+	records = (thd_trace_record_t *) (names + name_count);
+	names_used = 0;
+
+	clock_gettime(CLOCK_REALTIME, &real);
+	clock_gettime(CLOCK_MONOTONIC, &mono);
+
+	memcpy(header->magic, "THDTRACE", sizeof(header->magic));
+	header->version = trace_version;
+	header->record_size = sizeof(thd_trace_record_t);
+	header->record_count = record_count;
+	header->name_count = name_count;
+	header->names_offset = trace_header_size;
+	header->records_offset = trace_header_size
+			+ name_count * sizeof(thd_trace_name_t);
+	header->realtime_offset_ns = (real.tv_sec - mono.tv_sec) * 1000000000LL
+			+ (real.tv_nsec - mono.tv_nsec);
+	header->head.store(0, std::memory_order_release);
+
+	thd_log_info("Trace file %s: %u records\n", path.c_str(), record_count);
+
+	return THD_SUCCESS;
+}
+
+void cthd_trace::close() {
+	if (!map)
+		return;
+
+	munmap(map, map_size);
+	map = nullptr;
+	header = nullptr;
+	names = nullptr;
+	records = nullptr;
+}
+
+// Hot path: no locks and no system calls
+void cthd_trace::record(thd_trace_event_t type, int id, int aux,
+		long long value) {
+	if (!map)
+		return;
+
+	uint64_t pos = header->head.fetch_add(1, std::memory_order_relaxed);
+	thd_trace_record_t *rec = &records[pos & (record_count - 1)];
+
+	rec->seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	rec->time_ns = thd_get_monotonic_nsec();
+	rec->type = type;
+	rec->id = id;
+	rec->aux = aux;
+	rec->value = value;
+
+	rec->seq.store(pos + 1, std::memory_order_release);
+}
+
+void cthd_trace::clear_names() {
+	if (!map)
+		return;
+
+	memset(names, 0, name_count * sizeof(thd_trace_name_t));
+	names_used = 0;
+}
+
+void cthd_trace::add_name(thd_trace_name_kind_t kind, int id,
+		const std::string &name) {
+	if (!map || names_used >= name_count)
+		return;
+
+	thd_trace_name_t *entry = &names[names_used++];
+
+	entry->kind = kind;
+	entry->id = id;
+	strncpy(entry->name, name.c_str(), sizeof(entry->name) - 1);
+}
+
+int cthd_trace_reader::load(const std::string &path) {
+	std::vector<char> data;
+	struct stat st;
+	int fd;
+
+	entries.clear();
+	names.clear();
+
+	fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		thd_log_error("Can't open trace %s: %s\n", path.c_str(),
+				strerror(errno));
+		return THD_ERROR;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(thd_trace_header_t)) {
+		thd_log_error("Invalid trace %s\n", path.c_str());
+		::close(fd);
+		return THD_ERROR;
+	}
+
+	data.resize(st.st_size);
+	ssize_t len = ::read(fd, data.data(), data.size());
+	::close(fd);
+	if (len != st.st_size) {
+		thd_log_error("Can't read trace %s\n", path.c_str());
+		return THD_ERROR;
+	}
+
+	const thd_trace_header_t *hdr = (const thd_trace_header_t *) data.data();
+	if (memcmp(hdr->magic, "THDTRACE", sizeof(hdr->magic))
+			|| hdr->version != cthd_trace::trace_version
+			|| hdr->record_size != sizeof(thd_trace_record_t)
+			|| hdr->names_offset + hdr->name_count * sizeof(thd_trace_name_t)
+					> data.size()
+			|| hdr->records_offset
+					+ (uint64_t) hdr->record_count * sizeof(thd_trace_record_t)
+					> data.size()) {
+		thd_log_error("Unsupported trace %s\n", path.c_str());
+		return THD_ERROR;
+	}
+
+	const thd_trace_name_t *name = (const thd_trace_name_t *) (data.data()
+			+ hdr->names_offset);
+	for (unsigned int i = 0; i < hdr->name_count && name[i].kind; ++i)
+		names.push_back(name[i]);
+
+	const thd_trace_record_t *rec = (const thd_trace_record_t *) (data.data()
+			+ hdr->records_offset);
+	for (unsigned int i = 0; i < hdr->record_count; ++i) {
+		uint64_t seq = rec[i].seq.load(std::memory_order_relaxed);
+		trace_entry_t entry;
+
+		// Empty, or was being written when the file was copied
+		if (!seq || (seq - 1) % hdr->record_count != i)
+			continue;
+
+		entry.seq = seq;
+		entry.time_ns = rec[i].time_ns;
+		entry.type = rec[i].type;
+		entry.id = rec[i].id;
+		entry.aux = rec[i].aux;
+		entry.value = rec[i].value;
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(),
+			[](const trace_entry_t &a, const trace_entry_t &b) {
+				return a.seq < b.seq;
+			});
+
+	thd_log_info("Trace %s: %zu records\n", path.c_str(), entries.size());
+
+	return THD_SUCCESS;
+}
+
+std::string cthd_trace_reader::get_name(thd_trace_name_kind_t kind, int id) {
+	for (unsigned int i = 0; i < names.size(); ++i) {
+		if (names[i].kind == kind && names[i].id == id)
+			return std::string(names[i].name,
+					strnlen(names[i].name, sizeof(names[i].name)));
+	}
+
+	return "";
+}
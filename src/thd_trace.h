@@ -0,0 +1,131 @@
+/*
+ * thd_trace.h: flight recorder interface
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+
+#ifndef THD_TRACE_H_
+#define THD_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The file layout is read by test/thermald_trace_reader.py, bump
+// trace_version on any change.
+typedef enum : uint16_t {
+	TRACE_SAMPLE = 1,	// id: sensor, value: temp in mC
+	TRACE_TRIP_ON,		// id: zone, aux: trip, value: temp in mC
+	TRACE_TRIP_OFF,		// id: zone, aux: trip, value: temp in mC
+	TRACE_CDEV_STATE,	// id: cdev, aux: zone, value: new state
+	TRACE_RAPL_POWER,	// id: RAPL domain type, value: power in uW
+} thd_trace_event_t;
+
+typedef enum : uint16_t {
+	TRACE_NAME_SENSOR = 1, TRACE_NAME_ZONE, TRACE_NAME_CDEV
+} thd_trace_name_kind_t;
+
+typedef struct {
+	std::atomic<uint64_t> seq;	// Position + 1 once complete, 0 while written
+	int64_t time_ns;			// CLOCK_MONOTONIC
+	uint16_t type;
+	uint16_t id;
+	int32_t aux;
+	int64_t value;
+} thd_trace_record_t;
+
+typedef struct {
+	uint16_t kind;
+	uint16_t id;
+	char name[28];
+} thd_trace_name_t;
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t record_count;
+	uint32_t name_count;
+	uint64_t names_offset;
+	uint64_t records_offset;
+	int64_t realtime_offset_ns;	// CLOCK_REALTIME - CLOCK_MONOTONIC at open
+	std::atomic<uint64_t> head;	// Next record position
+} thd_trace_header_t;
+
+// Fixed size circular trace in a file mapped with MAP_SHARED. Recording is
+// only memory stores, the page cache keeps the data when thermald dies.
+class cthd_trace {
+public:
+	static constexpr uint32_t trace_version = 1;
+
+private:
+	static constexpr uint32_t record_count = 65536; // Power of 2
+	static constexpr uint32_t name_count = 512;
+
+	void *map;
+	size_t map_size;
+	thd_trace_header_t *header;
+	thd_trace_name_t *names;
+	thd_trace_record_t *records;
+	unsigned int names_used;
+
+public:
+	cthd_trace();
+	~cthd_trace();
+
+	int open(const std::string &path);
+	void close();
+	bool is_open() {
+		return map != nullptr;
+	}
+
+	void record(thd_trace_event_t type, int id, int aux, long long value);
+	void clear_names();
+	void add_name(thd_trace_name_kind_t kind, int id, const std::string &name);
+};
+
+// Complete records of a trace file in sequence order, used by replay
+class cthd_trace_reader {
+public:
+	typedef struct {
+		uint64_t seq;
+		long long time_ns;
+		int type;
+		int id;
+		int aux;
+		long long value;
+	} trace_entry_t;
+
+private:
+	std::vector<trace_entry_t> entries;
+	std::vector<thd_trace_name_t> names;
+
+public:
+	int load(const std::string &path);
+	const std::vector<trace_entry_t> &get_entries() {
+		return entries;
+	}
+	std::string get_name(thd_trace_name_kind_t kind, int id);
+};
+
+#endif /* THD_TRACE_H_ */
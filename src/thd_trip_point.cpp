@@ -28,13 +28,14 @@
 #include <sys/reboot.h>
 #include "thd_trip_point.h"
 #include "thd_engine.h"
+#include "thd_util.h"
 
 cthd_trip_point::cthd_trip_point(int _index, trip_point_type_t _type, unsigned
 int _temp, unsigned int _hyst, int _zone_id, int _sensor_id,
 		trip_control_type_t _control_type) :
 		index(_index), type(_type), temp(_temp), hyst(_hyst), control_type(
 				_control_type), zone_id(_zone_id), sensor_id(_sensor_id), trip_on(
-				false), poll_on(false), depend_cdev(nullptr), depend_cdev_state(0), depend_cdev_state_rel(
+				false), poll_on(false), cdevs_idle(true), crossings(0), depend_cdev(nullptr), depend_cdev_state(0), depend_cdev_state_rel(
 				EQUAL), crit_trip_count(0) {
 	thd_log_debug("Add trip pt %d:%d:0x%x:%d:%d\n", type, zone_id, sensor_id,
 			temp, hyst);
@@ -236,11 +237,21 @@ bool cthd_trip_point::thd_trip_point_check(int id, unsigned int read_temp,
 		if (read_temp >= temp) {
 			thd_log_debug("Trip point applicable >  %d:%d\n", index, temp);
 			on = 1;
+			if (!trip_on) {
+				thd_engine->get_trace().record(TRACE_TRIP_ON, zone_id, index,
+						read_temp);
+				++crossings;
+			}
 			trip_on = true;
 		} else if ((trip_on && (read_temp + hyst) < temp)
 				|| (!trip_on && read_temp < temp)) {
 			thd_log_debug("Trip point applicable <  %d:%d\n", index, temp);
 			off = 1;
+			if (trip_on) {
+				thd_engine->get_trace().record(TRACE_TRIP_OFF, zone_id, index,
+						read_temp);
+				++crossings;
+			}
 			trip_on = false;
 		}
 	} else
@@ -253,16 +264,17 @@ bool cthd_trip_point::thd_trip_point_check(int id, unsigned int read_temp,
 	thd_log_debug("cdev size for this trippoint %lu\n",
 			(unsigned long) cdevs.size());
 	if (on > 0) {
+		cdevs_idle = false;
 		for (unsigned i = 0; i < cdevs.size(); ++i) {
 			cthd_cdev *cdev = cdevs[i].cdev;
 
 			if (cdevs[i].sampling_priod) {
-				time_t tm;
-				time(&tm);
-				if ((tm - cdevs[i].last_op_time) < cdevs[i].sampling_priod) {
-					thd_log_debug("Too early to act zone:%d index %d tm %jd\n",
+				long long tm = thd_get_monotonic_msec();
+				if ((tm - cdevs[i].last_op_time)
+						< cdevs[i].sampling_priod * 1000LL) {
+					thd_log_debug("Too early to act zone:%d index %d tm %lld\n",
 							zone_id, cdev->thd_cdev_get_index(),
-							(intmax_t)tm - cdevs[i].last_op_time);
+							tm - cdevs[i].last_op_time);
 					break;
 				}
 				cdevs[i].last_op_time = tm;
@@ -297,6 +309,7 @@ bool cthd_trip_point::thd_trip_point_check(int id, unsigned int read_temp,
 	}
 
 	if (off > 0) {
+		cdevs_idle = true;
 		for (i = cdevs.size() - 1; i >= 0; --i) {
 
 			cthd_cdev *cdev = cdevs[i].cdev;
@@ -310,6 +323,7 @@ bool cthd_trip_point::thd_trip_point_check(int id, unsigned int read_temp,
 				continue;
 			}
 
+			cdevs_idle = false;
 			if (cdevs[i].target_state == TRIP_PT_INVALID_TARGET_STATE)
 				cdevs[i].target_state = cdev->get_min_state();
 
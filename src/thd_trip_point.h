@@ -58,7 +58,7 @@ public:
 	cthd_cdev *cdev;
 	int influence;
 	int sampling_priod;
-	time_t last_op_time;
+	long long last_op_time; // Monotonic msec
 	int target_state_valid;
 	int target_state;
 	pid_param_t pid_param;
@@ -117,6 +117,9 @@ private:
 	int sensor_id;
 	bool trip_on;
 	bool poll_on;
+	bool cdevs_idle;
+	// Number of on and off transitions
+	unsigned long crossings;
 
 	cthd_cdev *depend_cdev;
 	int depend_cdev_state;
@@ -173,6 +176,12 @@ public:
 	unsigned int get_trip_hyst() {
 		return hyst;
 	}
+	bool is_trip_on() const {
+		return trip_on;
+	}
+	unsigned long get_crossings() const {
+		return crossings;
+	}
 	void update_trip_temp(unsigned int _temp) {
 		temp = _temp;
 	}
@@ -188,6 +197,10 @@ public:
 	unsigned int get_cdev_count() {
 		return cdevs.size();
 	}
+	// Last check found nothing to do: not tripped and cdevs at min state
+	bool is_idle() const {
+		return !trip_on && !poll_on && cdevs_idle;
+	}
 
 
 	int is_target_valid(int &target_state) {
@@ -670,7 +670,8 @@ void cthd_acpi_rel::create_platform_conf() {
 	conf_file << prefix << "<Name>" << "_TRT export" << "</Name>"
 			<< "\n";
 
-	ifstream product_name("/sys/class/dmi/id/product_name");
+	ifstream product_name(
+			csys_fs::map_path("/sys/class/dmi/id/product_name"));
 
 	conf_file << indentation << "<ProductName>";
 #if 0
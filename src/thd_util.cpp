@@ -22,8 +22,13 @@
  *
  */
 
+#include <atomic>
+#include <time.h>
 #include "thd_util.h"
 
+// Replay runs on the recorded time line, -1 for the real clock
+static std::atomic<long long> virtual_time_ns(-1);
+
 bool starts_with(const std::string& s, const char *prefix)
 {
     size_t len = strlen(prefix);
@@ -65,3 +70,31 @@ int thd_strcasecmp_n(const char *param1, const char *param2) {
 
 	return strncasecmp(param1, param2, thd_cmp_len(param1, param2));
 }
+
+void thd_set_virtual_time(long long nsec) {
+	virtual_time_ns.store(nsec, std::memory_order_relaxed);
+}
+
+long long thd_get_monotonic_msec() {
+	long long virt = virtual_time_ns.load(std::memory_order_relaxed);
+	struct timespec ts;
+
+	if (virt >= 0)
+		return virt / 1000000;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+long long thd_get_monotonic_nsec() {
+	long long virt = virtual_time_ns.load(std::memory_order_relaxed);
+	struct timespec ts;
+
+	if (virt >= 0)
+		return virt;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -36,4 +36,10 @@ size_t thd_cmp_len(const char *param1, const char *param2);
 int thd_strcmp_n(const char *param1, const char *param2);
 int thd_strcasecmp_n(const char *param1, const char *param2);
 
+// Monotonic clock in msec, not affected by wall clock changes
+long long thd_get_monotonic_msec();
+long long thd_get_monotonic_nsec();
+// Fix the monotonic clock at nsec for replay, -1 restores the real clock
+void thd_set_virtual_time(long long nsec);
+
 #endif /* THD_UTIL_H_ */
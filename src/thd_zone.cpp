@@ -37,7 +37,8 @@
 cthd_zone::cthd_zone(int _index, std::string control_path, sensor_relate_t rel) :
 		index(_index), zone_sysfs(std::move(control_path)), zone_temp(0), zone_active(
 				false), zone_cdev_binded_status(false), type_str(), sensor_rel(
-				rel) {
+				rel), next_sample_time(0), uevent_debounce_interval(-1), last_uevent_time(
+				0), uevent_pending_time(0), eval_dirty(true) {
 	thd_log_debug("Added zone index:%d\n", index);
 }
 
@@ -50,6 +51,7 @@ cthd_zone::~cthd_zone() {
 }
 
 void cthd_zone::thermal_zone_temp_change(int id, unsigned int temp, int pref) {
+	cthd_stat_timer timer(thd_engine->get_stats(), STAT_TRIPS);
 	int i, count;
 	bool reset = false;
 
@@ -69,6 +71,7 @@ void cthd_zone::update_zone_preference() {
 	if (!zone_active)
 		return;
 	thd_log_debug("update_zone_preference\n");
+	eval_dirty = true;
 
 	for (unsigned int i = 0; i < sensors.size(); ++i) {
 		cthd_sensor *sensor;
@@ -113,6 +116,8 @@ void cthd_zone::sort_and_update_poll_trip() {
 	thd_log_debug("sort_and_update_poll_trip: trip_points_size =%zu\n",
 			trip_points.size());
 
+	eval_dirty = true;
+
 	for (unsigned int i = 0; i < trip_points.size(); ++i) {
 		if (trip_points[i].get_trip_type() == POLLING) {
 			thd_log_debug("polling trip already present\n");
@@ -180,19 +185,49 @@ int cthd_zone::zone_update() {
 	return THD_SUCCESS;
 }
 
+// When nothing changed since the last evaluation and the zone is below
+// every trip with all its cdevs at min state, running the trips again is a
+// no-op.
+bool cthd_zone::zone_eval_needed() {
+	if (eval_dirty || sensor_temps.size() != last_sensor_temps.size())
+		return true;
+
+	for (unsigned int i = 0; i < sensor_temps.size(); ++i) {
+		if (sensor_temps[i] != last_sensor_temps[i])
+			return true;
+	}
+
+	for (unsigned int i = 0; i < trip_points.size(); ++i) {
+		if (!trip_points[i].is_idle()
+				|| zone_temp >= trip_points[i].get_trip_temp())
+			return true;
+	}
+
+	return false;
+}
+
 void cthd_zone::read_zone_temp() {
 	if (zone_active) {
-		unsigned int temp;
 		zone_temp = 0;
+		sensor_temps.resize(sensors.size());
+		for (unsigned int i = 0; i < sensors.size(); ++i) {
+			sensor_temps[i] = sensors[i]->read_temperature();
+			if (zone_temp < sensor_temps[i])
+				zone_temp = sensor_temps[i];
+		}
+
+		if (!zone_eval_needed()) {
+			thd_log_debug("zone %s unchanged at %u, skip\n", type_str.c_str(),
+					zone_temp);
+			return;
+		}
+		eval_dirty = false;
+		last_sensor_temps = sensor_temps;
+
 		for (unsigned int i = 0; i < sensors.size(); ++i) {
-			cthd_sensor *sensor;
-			sensor = sensors[i];
-			temp = sensor->read_temperature();
-			if (zone_temp < temp)
-				zone_temp = temp;
 			if (sensor_rel == SENSOR_INDEPENDENT)
-				thermal_zone_temp_change(sensor->get_index(), temp,
-						thd_engine->get_preference());
+				thermal_zone_temp_change(sensors[i]->get_index(),
+						sensor_temps[i], thd_engine->get_preference());
 		}
 		if (sensor_rel == SENSORS_CORELATED && zone_temp)
 			thermal_zone_temp_change(sensors[0]->get_index(), zone_temp,
@@ -248,9 +283,10 @@ int cthd_zone::bind_cooling_device(trip_point_type_t type,
 		added = true;
 	}
 #endif
-	if (added)
+	if (added) {
+		eval_dirty = true;
 		return THD_SUCCESS;
-	else
+	} else
 		return THD_ERROR;
 }
 
@@ -62,12 +62,21 @@ protected:
 	std::string type_str;
 	std::vector<cthd_sensor *> sensors;
 	sensor_relate_t sensor_rel;
+	long long next_sample_time;
+	int uevent_debounce_interval;
+	long long last_uevent_time;
+	long long uevent_pending_time;
+	// Sensor readings of this and the last evaluated sample
+	std::vector<unsigned int> sensor_temps;
+	std::vector<unsigned int> last_sensor_temps;
+	bool eval_dirty;
 
 	virtual int zone_bind_sensors() = 0;
 	void thermal_zone_temp_change(int id, unsigned int temp, int pref);
 
 private:
 	void sort_and_update_poll_trip();
+	bool zone_eval_needed();
 public:
 	static constexpr unsigned int def_async_trip_offset = 5000;
 	static constexpr unsigned int def_async_trip_offset_pct = 10;
@@ -88,6 +97,45 @@ public:
 		return index;
 	}
 
+	// Temperature of the last evaluation
+	unsigned int get_zone_temp() {
+		return zone_temp;
+	}
+
+	// Monotonic time in msec, when this zone is due for next sampling
+	long long get_next_sample_time() {
+		return next_sample_time;
+	}
+	void set_next_sample_time(long long time) {
+		next_sample_time = time;
+	}
+
+	// Minimum msec between two uevent triggered evaluations, -1 for default
+	int get_uevent_debounce_interval() {
+		return uevent_debounce_interval;
+	}
+	void set_uevent_debounce_interval(int interval) {
+		uevent_debounce_interval = interval;
+	}
+	long long get_last_uevent_time() {
+		return last_uevent_time;
+	}
+	void set_last_uevent_time(long long time) {
+		last_uevent_time = time;
+	}
+	// Set when a uevent was debounced, evaluated at this time instead
+	long long get_uevent_pending_time() {
+		return uevent_pending_time;
+	}
+	void set_uevent_pending_time(long long time) {
+		uevent_pending_time = time;
+	}
+
+	// Force trip evaluation on the next sample, even if temp is unchanged
+	void mark_dirty() {
+		eval_dirty = true;
+	}
+
 	void add_trip(cthd_trip_point &trip, int force = 0);
 	void update_trip_temp(cthd_trip_point &trip);
 	void update_highest_trip_temp(cthd_trip_point &trip);
@@ -101,6 +149,7 @@ public:
 				break;
 			}
 		}
+		eval_dirty = true;
 		zone_active = true;
 	}
 	;
@@ -75,17 +75,28 @@
 
 extern gboolean log_debug;
 
+// Deferred logging ring, formatted by a drainer thread
+// Writes one formatted line, with the time it was logged
+typedef void (*thd_log_writer_t)(int level, time_t seconds,
+		const char *message);
+void thd_log_ring_record(int level, const char *fmt, ...)
+		__attribute__((format(printf, 2, 3)));
+void thd_log_ring_init(int level_mask, thd_log_writer_t writer);
+int thd_log_ring_start();
+void thd_log_ring_flush();
+
 // Log macros
 #define thd_log_fatal		g_error		// Print error and terminate
 #define thd_log_error		g_critical
 #define thd_log_warn		g_warning
 #define thd_log_msg		g_message
+// Arguments of disabled debug records are not evaluated
 #define thd_log_debug(...) \
 	do { \
-		if (G_UNLIKELY (!g_log_writer_default_would_drop (G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN)) || log_debug) \
-			g_debug(__VA_ARGS__); \
+		if (G_UNLIKELY(log_debug)) \
+			thd_log_ring_record(G_LOG_LEVEL_DEBUG, __VA_ARGS__); \
 	} while (0)
-#define thd_log_info(...)	g_log(nullptr, G_LOG_LEVEL_INFO, __VA_ARGS__)
+#define thd_log_info(...)	thd_log_ring_record(G_LOG_LEVEL_INFO, __VA_ARGS__)
 #else
 static int dummy_printf(const char *__restrict __format, ...) {
 	return 0;
@@ -113,6 +124,12 @@ class cthd_engine;
 class cthd_engine_therm_sysfs;
 extern std::unique_ptr<cthd_engine> thd_engine;
 extern int thd_poll_interval;
+extern int thd_sensor_max_staleness;
+extern char *thd_replay_file;
+extern bool thd_telemetry_enable;
+extern int thd_metrics_interval;
+extern char *thd_metrics_file;
+extern int thd_replay_repeat;
 extern bool thd_ignore_default_control;
 extern bool workaround_enabled;
 extern bool disable_active_power;
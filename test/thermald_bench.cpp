@@ -0,0 +1,441 @@
+/*
+ * thermald_bench.cpp: microbenchmarks of the daemon hot paths
+ *
+ * Copyright (C) 2026 Intel Corporation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 or later as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ *
+ * Author Name <Srinivas.Pandruvada@linux.intel.com>
+ *
+ */
+
+/* Built and run with "make bench". Sysfs is faked by a tree on tmpfs, so
+ * the numbers don't depend on the platform drivers. Prints CSV with one
+ * row per benchmark to stdout:
+ * version,benchmark,iterations,ns_per_op,p50_ns,p99_ns,max_ns
+ * Percentiles are of the per op time of rounds of batch_size ops.
+ * Fails when an engine loop iteration allocates after warm-up.
+ */
+
+#include <atomic>
+#include <ftw.h>
+#include <functional>
+#include <new>
+#include "thermald.h"
+#include "thd_engine.h"
+#include "thd_engine_default.h"
+#include "thd_engine_stats.h"
+#include "thd_gddv.h"
+#include "thd_lzma_dec.h"
+#include "thd_simulator.h"
+
+// Globals of the daemon, set by main.cpp there
+gboolean log_debug = FALSE;
+int thd_poll_interval = 4;
+int thd_sensor_max_staleness = 500;
+char *thd_replay_file = nullptr;
+int thd_replay_repeat = 1;
+bool thd_telemetry_enable = false;
+int thd_metrics_interval = 0;
+char *thd_metrics_file = nullptr;
+bool thd_ignore_default_control = false;
+bool workaround_enabled = false;
+bool disable_active_power = false;
+bool ignore_critical = false;
+bool power_floor_enable = false;
+
+static constexpr int rounds = 200;
+static constexpr int batch_size = 100;
+// Header size of the data vault, the LZMA stream follows
+static constexpr int gddv_header_size = 0x94;
+// Thermal zones of the generated /sys, each with a passive trip on its own
+// cooling device
+static constexpr int sys_zone_count = 8;
+static constexpr int passive_temp = 80000;
+
+static std::string root;
+
+// Heap allocations made while count_allocations is set
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<bool> count_allocations(false);
+
+void *operator new(size_t size) {
+	if (count_allocations.load(std::memory_order_relaxed))
+		allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+// Not inlined, GCC would pair the inlined free() with operator new
+__attribute__((noinline)) void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+// Default engine on the generated /sys, its loop run without the thread
+class cthd_engine_bench: public cthd_engine_default {
+public:
+	int init_loop() {
+		// The trips are of kernel zones, as with --exclusive-control
+		set_control_mode(EXCLUSIVE);
+		if (thd_engine_init(true) != THD_SUCCESS)
+			return THD_ERROR;
+
+		// As thd_engine_start(), the zone sensors can't notify
+		poll_timeout_msec = def_poll_interval;
+		rapl_power_meter.rapl_start_measure_power();
+		register_timers();
+
+		return THD_SUCCESS;
+	}
+
+	void run_loop(long long now) {
+		process_tick(now);
+		process_messages();
+	}
+};
+
+static void run_bench(const char *name, const std::function<void()> &op) {
+	cthd_latency_histogram hist;
+	struct timespec start, end;
+
+	for (int i = 0; i < batch_size; ++i)
+		op();
+
+	for (int r = 0; r < rounds; ++r) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < batch_size; ++i)
+			op();
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		hist.record(((end.tv_sec - start.tv_sec) * 1000000000LL
+				+ end.tv_nsec - start.tv_nsec) / batch_size);
+	}
+
+	printf("%s,%s,%d,%lld,%lld,%lld,%lld\n", PACKAGE_VERSION, name,
+			rounds * batch_size, hist.get_avg(), hist.percentile(50),
+			hist.percentile(99), hist.get_max());
+	fflush(stdout);
+}
+
+static int write_file(const std::string &path, const char *buf, size_t len,
+		mode_t mode) {
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+
+	if (fd < 0)
+		return THD_ERROR;
+
+	ssize_t ret = write(fd, buf, len);
+	close(fd);
+
+	return ret == (ssize_t) len ? THD_SUCCESS : THD_ERROR;
+}
+
+static int write_file(const std::string &path, const std::string &val,
+		mode_t mode = 0644) {
+	return write_file(path, val.c_str(), val.size(), mode);
+}
+
+// Replace the value of an open file, without allocating
+static void rewrite_file(int fd, long long value) {
+	char buf[32];
+	int len = snprintf(buf, sizeof(buf), "%lld\n", value);
+
+	if (pwrite(fd, buf, len, 0) != len || ftruncate(fd, len))
+		fprintf(stderr, "Rewrite failed: %s\n", strerror(errno));
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag,
+		struct FTW *ftwbuf) {
+	return remove(path);
+}
+
+static void remove_tree() {
+	if (!root.empty())
+		nftw(root.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+// A thermal zone and the INT3400 attributes the data vault refers to, and
+// a /sys with the zones, cooling devices and RAPL package of the tick check
+static int create_tree(const std::vector<char> &data_vault) {
+	char templ[] = "/dev/shm/thermald_bench.XXXXXX";
+	char templ_tmp[] = "/tmp/thermald_bench.XXXXXX";
+	char *dir = mkdtemp(templ);
+
+	if (!dir)
+		dir = mkdtemp(templ_tmp);
+	if (!dir)
+		return THD_ERROR;
+
+	root = dir;
+	atexit(remove_tree);
+
+	if (mkdir((root + "/thermal_zone0").c_str(), 0755)
+			|| mkdir((root + "/INT3400:00").c_str(), 0755))
+		return THD_ERROR;
+
+	int ret = write_file(root + "/thermal_zone0/type", "x86_pkg_temp\n");
+	ret |= write_file(root + "/thermal_zone0/temp", "45000\n");
+	ret |= write_file(root + "/INT3400:00/data_vault", data_vault.data(),
+			data_vault.size(), 0644);
+	for (int i = 0; i < 6; ++i)
+		ret |= write_file(root + "/INT3400:00/odvp" + std::to_string(i),
+				"0\n");
+
+	std::string thermal = root + "/sys/class/thermal/";
+	std::string powercap = root + "/sys/class/powercap/";
+	std::string rapl = powercap + "intel-rapl/intel-rapl:0/";
+	for (const std::string &dir : { root + "/sys", root + "/sys/class", thermal,
+			powercap, powercap + "intel-rapl", rapl }) {
+		if (mkdir(dir.c_str(), 0755))
+			return THD_ERROR;
+	}
+
+	for (int i = 0; i < sys_zone_count; ++i) {
+		std::string cdev = thermal + "cooling_device" + std::to_string(i);
+		std::string zone = thermal + "thermal_zone" + std::to_string(i);
+
+		if (mkdir(cdev.c_str(), 0755) || mkdir(zone.c_str(), 0755))
+			return THD_ERROR;
+		ret |= write_file(cdev + "/type", "bench_cdev" + std::to_string(i)
+				+ "\n", 0444);
+		ret |= write_file(cdev + "/max_state", "10\n", 0444);
+		ret |= write_file(cdev + "/cur_state", "0\n");
+
+		ret |= write_file(zone + "/type", "bench_zone" + std::to_string(i)
+				+ "\n", 0444);
+		ret |= write_file(zone + "/temp", "45000\n");
+		// Read only trips are for control, not notification
+		ret |= write_file(zone + "/trip_point_0_type", "passive\n", 0444);
+		ret |= write_file(zone + "/trip_point_0_temp",
+				std::to_string(passive_temp) + "\n", 0444);
+		ret |= write_file(zone + "/trip_point_0_hyst", "0\n", 0444);
+		ret |= write_file(zone + "/cdev0_trip_point", "0\n", 0444);
+		if (symlink(("../cooling_device" + std::to_string(i)).c_str(),
+				(zone + "/cdev0").c_str()))
+			return THD_ERROR;
+	}
+
+	ret |= write_file(rapl + "name", "package-0\n", 0444);
+	ret |= write_file(rapl + "enabled", "1\n");
+	ret |= write_file(rapl + "energy_uj", "0\n");
+	ret |= write_file(rapl + "max_energy_range_uj", "262143328850\n", 0444);
+	ret |= write_file(rapl + "constraint_0_name", "long_term\n", 0444);
+	ret |= write_file(rapl + "constraint_0_power_limit_uw", "15000000\n");
+	ret |= write_file(rapl + "constraint_0_max_power_uw", "25000000\n", 0444);
+	ret |= write_file(rapl + "constraint_0_time_window_us", "28000000\n");
+
+	return ret;
+}
+
+static void bench_sysfs() {
+	csys_fs sysfs(root + "/thermal_zone0/");
+	csys_fs_attr attr;
+	int temp;
+
+	run_bench("csys_fs_read", [&]() {
+		sysfs.read("temp", &temp);
+	});
+
+	attr.open(root + "/thermal_zone0/temp");
+	run_bench("csys_fs_attr_read", [&]() {
+		attr.read(&temp);
+	});
+}
+
+// Trip checks of a zone crossing its trip, with the exponential controller
+static void bench_zone() {
+	std::unique_ptr<cthd_sensor_sim> sensor(new cthd_sensor_sim(0, "bench"));
+	std::unique_ptr<cthd_cdev_sim> cdev(
+			new cthd_cdev_sim(0, "bench_cdev", 100));
+	cthd_trip_point trip(0, PASSIVE, 80000, 0, 0, 0);
+	unsigned int temp = 70000;
+
+	cdev->set_debounce_interval(0);
+	trip.thd_trip_point_add_cdev(*cdev, cthd_trip_point::default_influence);
+	cthd_zone_sim zone(0, "bench", sensor.get(), trip);
+	zone.zone_update();
+	zone.set_zone_active();
+
+	run_bench("zone_temp_change", [&]() {
+		temp = temp >= 90000 ? 70000 : temp + 1000;
+		sensor->set_plant_temp(temp);
+		zone.zone_temperature_notification(0, 0);
+	});
+}
+
+// Several zones and trips limit one cdev to different target states
+static void bench_cdev_arbitration() {
+	static constexpr int limits = 8;
+	cthd_cdev_sim cdev(0, "bench_cdev", 100);
+	cthd_pid pid;
+	int state = 0;
+
+	cdev.set_debounce_interval(0);
+	run_bench("cdev_set_state_arbitration", [&]() {
+		int zone = state % limits;
+		bool activate = state < limits;
+
+		cdev.thd_cdev_set_state(80000, 80000, activate ? 85000 : 75000, 0,
+				activate, zone, 0, 1, (zone + 1) * 10, nullptr, pid, false,
+				0, 0, 0);
+		state = (state + 1) % (2 * limits);
+	});
+}
+
+static void bench_gddv(std::vector<char> &data_vault) {
+	std::string base_path = root + "/INT3400:00/";
+	csys_fs sysfs(base_path);
+	std::vector<char> buf(data_vault.size());
+
+	run_bench("gddv_parse", [&]() {
+		cthd_gddv gddv;
+
+		sysfs.read("data_vault", buf.data(), buf.size());
+		gddv.parse_data_vault(base_path, buf.data(), buf.size());
+	});
+
+	cthd_gddv gddv;
+	if (gddv.parse_data_vault(base_path, data_vault.data(), data_vault.size())
+			== THD_SUCCESS) {
+		run_bench("gddv_evaluate_conditions", [&]() {
+			gddv.evaluate_conditions();
+		});
+	}
+
+	const unsigned char *src = (const unsigned char *) data_vault.data()
+			+ gddv_header_size;
+	size_t src_len = data_vault.size() - gddv_header_size;
+	size_t dest_len = 0;
+
+	if (lzma_decompress(nullptr, &dest_len, src, src_len))
+		return;
+
+	std::vector<unsigned char> dest(dest_len);
+	run_bench("lzma_decompress", [&]() {
+		size_t len = dest.size();
+
+		lzma_decompress(dest.data(), &len, src, src_len);
+	});
+}
+
+// Whole loop iterations of the default engine on the generated /sys: RAPL
+// counters, timers, batch sensor reads and cdev sysfs writes. Sensors cross
+// the passive trips, so cdev states change in the counted ticks too. The
+// first ticks enter polling mode and reschedule the zones.
+static int check_tick_allocations() {
+	static constexpr int warmup_ticks = 100;
+	static constexpr int ticks = 1000;
+	cthd_engine_bench *engine = static_cast<cthd_engine_bench *>(
+			thd_engine.get());
+	std::vector<int> temp_fds;
+	long long now = 1000000;
+	long long energy = 0;
+	int ret = THD_SUCCESS;
+
+	if (engine->init_loop() != THD_SUCCESS) {
+		fprintf(stderr, "Engine init on the generated sysfs failed\n");
+		return THD_ERROR;
+	}
+
+	for (int i = 0; i < sys_zone_count; ++i)
+		temp_fds.push_back(open((root + "/sys/class/thermal/thermal_zone"
+				+ std::to_string(i) + "/temp").c_str(), O_WRONLY));
+	int energy_fd = open((root
+			+ "/sys/class/powercap/intel-rapl/intel-rapl:0/energy_uj").c_str(),
+			O_WRONLY);
+
+	auto tick = [&](int i) {
+		for (int j = 0; j < sys_zone_count; ++j)
+			rewrite_file(temp_fds[j], passive_temp - 6000
+					+ ((i + j) % 9) * 2000);
+		// 2.5 W at the default poll interval
+		energy += 10000000;
+		rewrite_file(energy_fd, energy);
+		now += cthd_engine::def_poll_interval;
+		engine->run_loop(now);
+	};
+
+	for (int i = 0; i < warmup_ticks; ++i)
+		tick(i);
+
+	allocations.store(0);
+	count_allocations.store(true);
+	for (int i = 0; i < ticks; ++i)
+		tick(i);
+	count_allocations.store(false);
+
+	if (allocations.load()) {
+		fprintf(stderr, "engine loop: %lu allocations in %d ticks\n",
+				allocations.load(), ticks);
+		ret = THD_ERROR;
+	}
+
+	for (int fd : temp_fds)
+		close(fd);
+	close(energy_fd);
+
+	return ret;
+}
+
+int main(int argc, char *argv[]) {
+	const char *vault_file = argc > 1 ? argv[1] : "test/test_data_vault.bin";
+	std::vector<char> data_vault;
+	csys_fs sysfs("");
+
+	size_t size = sysfs.size(vault_file);
+	if (size <= gddv_header_size) {
+		fprintf(stderr, "Usage: %s [data vault file]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	data_vault.resize(size);
+	if (sysfs.read(vault_file, data_vault.data(), size) < (int) size) {
+		fprintf(stderr, "Unable to read %s\n", vault_file);
+		return EXIT_FAILURE;
+	}
+
+	if (create_tree(data_vault) != THD_SUCCESS) {
+		fprintf(stderr, "Unable to create the sysfs tree\n");
+		return EXIT_FAILURE;
+	}
+
+	// Zones and cdevs report to the engine, it only has the zones found by
+	// check_tick_allocations(). RAPL domains are read on construction.
+	csys_fs::set_root(root);
+	thd_engine.reset(new cthd_engine_bench());
+
+	printf("version,benchmark,iterations,ns_per_op,p50_ns,p99_ns,max_ns\n");
+	bench_sysfs();
+	bench_zone();
+	bench_cdev_arbitration();
+	bench_gddv(data_vault);
+	int ret = check_tick_allocations();
+
+	thd_engine.reset();
+
+	return ret == THD_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
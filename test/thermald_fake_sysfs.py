@@ -0,0 +1,250 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# Generate a synthetic sysfs tree to test how thermald scales with the number
+# of sensors and cooling devices, on any Linux system.
+#
+# The tree has thermal zones with passive and active trips bound to cooling
+# devices, a coretemp hwmon device with many temperature inputs and RAPL
+# powercap domains. Run thermald on it with --sysfs-root, thermal zones are
+# only controlled with --exclusive-control:
+#
+# python3 thermald_fake_sysfs.py create /tmp/fake --zones 100 --cdevs 200 \
+#     --hwmon-temps 400
+# thermald --no-daemon --ignore-cpuid-check --exclusive-control \
+#     --loglevel=info --sysfs-root=/tmp/fake
+#
+# Then change temperatures and energy counters in the tree for some time and
+# make thermald log its engine statistics, which include the discovery time
+# and the cost per sampling tick:
+#
+# python3 thermald_fake_sysfs.py load /tmp/fake --duration 60 \
+#     --pid $(pidof thermald)
+#
+# Files are rewritten in place, not replaced, as thermald keeps them open.
+
+import argparse
+import os
+import random
+import shutil
+import signal
+import sys
+import time
+
+THERMAL = 'class/thermal'
+HWMON = 'class/hwmon/hwmon0'
+RAPL = 'devices/virtual/powercap/intel-rapl'
+DMI = 'class/dmi/id'
+
+PASSIVE_TEMP = 85000
+ACTIVE_TEMP = 90000
+MIN_TEMP = 40000
+MAX_TEMP = 95000
+MAX_ENERGY_RANGE = 262143328850
+# name of each RAPL domain, the package has the others as subdomains
+RAPL_DOMAINS = ['package-0', 'core', 'uncore', 'dram']
+
+
+def write(path, value, mode=0o644):
+    with open(path, 'w') as f:
+        f.write('%s\n' % value)
+    os.chmod(path, mode)
+
+
+def create_zone(sys_dir, index, cdevs):
+    path = os.path.join(sys_dir, THERMAL, 'thermal_zone%d' % index)
+    os.makedirs(path)
+    write(os.path.join(path, 'type'), 'fake_zone%d' % index, 0o444)
+    write(os.path.join(path, 'temp'), MIN_TEMP)
+    write(os.path.join(path, 'policy'), 'step_wise')
+    write(os.path.join(path, 'mode'), 'enabled')
+    # Trips writable by root are taken as notification trips, not as control
+    for trip, (trip_type, temp) in enumerate([('passive', PASSIVE_TEMP),
+                                              ('active', ACTIVE_TEMP)]):
+        prefix = os.path.join(path, 'trip_point_%d_' % trip)
+        write(prefix + 'type', trip_type, 0o444)
+        write(prefix + 'temp', temp, 0o444)
+        write(prefix + 'hyst', 2000, 0o444)
+    for i, cdev in enumerate(cdevs):
+        os.symlink('../cooling_device%d' % cdev,
+                   os.path.join(path, 'cdev%d' % i))
+        write(os.path.join(path, 'cdev%d_trip_point' % i), i % 2, 0o444)
+
+
+def create_cdev(sys_dir, index):
+    path = os.path.join(sys_dir, THERMAL, 'cooling_device%d' % index)
+    os.makedirs(path)
+    write(os.path.join(path, 'type'), 'fake_cdev%d' % index, 0o444)
+    write(os.path.join(path, 'max_state'), 10, 0o444)
+    write(os.path.join(path, 'cur_state'), 0)
+
+
+def create_hwmon(sys_dir, count):
+    path = os.path.join(sys_dir, HWMON)
+    os.makedirs(path)
+    write(os.path.join(path, 'name'), 'coretemp', 0o444)
+    for i in range(1, count + 1):
+        prefix = os.path.join(path, 'temp%d_' % i)
+        write(prefix + 'label', 'Core %d' % (i - 1), 0o444)
+        write(prefix + 'input', MIN_TEMP)
+        write(prefix + 'max', 100000, 0o444)
+        write(prefix + 'crit', 100000, 0o444)
+
+
+def create_rapl_domain(path, name):
+    os.makedirs(path)
+    write(os.path.join(path, 'name'), name, 0o444)
+    write(os.path.join(path, 'enabled'), 1)
+    write(os.path.join(path, 'energy_uj'), 0)
+    write(os.path.join(path, 'max_energy_range_uj'), MAX_ENERGY_RANGE, 0o444)
+    for i, constraint in enumerate(['long_term', 'short_term']):
+        prefix = os.path.join(path, 'constraint_%d_' % i)
+        write(prefix + 'name', constraint, 0o444)
+        write(prefix + 'power_limit_uw', 15000000)
+        write(prefix + 'max_power_uw', 25000000, 0o444)
+        write(prefix + 'time_window_us', 28000000)
+
+
+def create_rapl(sys_dir):
+    package = os.path.join(sys_dir, RAPL, 'intel-rapl:0')
+    create_rapl_domain(package, RAPL_DOMAINS[0])
+    for i, name in enumerate(RAPL_DOMAINS[1:]):
+        create_rapl_domain(os.path.join(package, 'intel-rapl:0:%d' % i), name)
+    os.makedirs(os.path.join(sys_dir, 'class/powercap'))
+    os.symlink('../../devices/virtual/powercap/intel-rapl',
+               os.path.join(sys_dir, 'class/powercap/intel-rapl'))
+
+
+def create_dmi(sys_dir):
+    path = os.path.join(sys_dir, DMI)
+    os.makedirs(path)
+    for name in ['sys_vendor', 'product_name', 'product_family',
+                 'product_sku']:
+        write(os.path.join(path, name), 'thermald fake sysfs', 0o444)
+    write(os.path.join(path, 'product_uuid'),
+          '00000000-0000-0000-0000-000000000000', 0o444)
+
+
+def create(args):
+    sys_dir = os.path.join(args.root, 'sys')
+    if os.path.exists(sys_dir):
+        if not args.force:
+            sys.exit('%s exists, use --force to replace it' % sys_dir)
+        shutil.rmtree(sys_dir)
+
+    os.makedirs(os.path.join(sys_dir, THERMAL))
+    for i in range(args.cdevs):
+        create_cdev(sys_dir, i)
+    for i in range(args.zones):
+        create_zone(sys_dir, i, range(i, args.cdevs, args.zones))
+    if args.hwmon_temps:
+        create_hwmon(sys_dir, args.hwmon_temps)
+    if not args.no_rapl:
+        create_rapl(sys_dir)
+    create_dmi(sys_dir)
+
+    print('%d sensors, %d cooling devices, %d zones in %s' %
+          (args.zones + args.hwmon_temps, args.cdevs, args.zones, sys_dir))
+
+
+def temp_files(sys_dir):
+    files = []
+    thermal = os.path.join(sys_dir, THERMAL)
+    for name in os.listdir(thermal):
+        if name.startswith('thermal_zone'):
+            files.append(os.path.join(thermal, name, 'temp'))
+    hwmon = os.path.join(sys_dir, HWMON)
+    if os.path.isdir(hwmon):
+        for name in os.listdir(hwmon):
+            if name.startswith('temp') and name.endswith('_input'):
+                files.append(os.path.join(hwmon, name))
+    return files
+
+
+def energy_files(sys_dir):
+    files = []
+    for path, _, names in os.walk(os.path.join(sys_dir, RAPL)):
+        if 'energy_uj' in names:
+            files.append(os.path.join(path, 'energy_uj'))
+    return files
+
+
+def rewrite(path, value):
+    with open(path, 'r+') as f:
+        f.write('%d\n' % value)
+        f.truncate()
+
+
+def load(args):
+    sys_dir = os.path.join(args.root, 'sys')
+    temps = {path: random.randint(MIN_TEMP, MAX_TEMP)
+             for path in temp_files(sys_dir)}
+    energy = {path: 0 for path in energy_files(sys_dir)}
+    if not temps:
+        sys.exit('No sensors in %s' % sys_dir)
+
+    # Temperatures follow a random walk over the trips, so zones throttle
+    # and release their cooling devices
+    end = time.monotonic() + args.duration
+    steps = 0
+    while time.monotonic() < end:
+        for path, temp in temps.items():
+            temp += random.randint(-2000, 2000)
+            temp = min(max(temp, MIN_TEMP), MAX_TEMP)
+            temps[path] = temp
+            rewrite(path, temp)
+        for path in energy:
+            energy[path] = ((energy[path] + int(args.power * args.interval))
+                            % MAX_ENERGY_RANGE)
+            rewrite(path, energy[path])
+        steps += 1
+        time.sleep(args.interval)
+
+    print('%d updates of %d sensors' % (steps, len(temps)))
+    if args.pid:
+        # thermald logs its engine statistics on SIGUSR1
+        os.kill(args.pid, signal.SIGUSR1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate and drive a fake sysfs tree for thermald')
+    sub = parser.add_subparsers(dest='command')
+    sub.required = True
+
+    parser_create = sub.add_parser('create', help='create the tree')
+    parser_create.add_argument('root', help='directory for the sys tree')
+    parser_create.add_argument('--zones', type=int, default=100,
+                               help='thermal zones, each is also a sensor')
+    parser_create.add_argument('--cdevs', type=int, default=200,
+                               help='cooling devices')
+    parser_create.add_argument('--hwmon-temps', type=int, default=400,
+                               help='coretemp hwmon temperature inputs')
+    parser_create.add_argument('--no-rapl', action='store_true',
+                               help='no powercap RAPL domains')
+    parser_create.add_argument('--force', action='store_true',
+                               help='replace an existing tree')
+    parser_create.set_defaults(func=create)
+
+    parser_load = sub.add_parser('load',
+                                 help='change temperatures and energy')
+    parser_load.add_argument('root', help='directory of the sys tree')
+    parser_load.add_argument('--interval', type=float, default=0.5,
+                             help='seconds between updates')
+    parser_load.add_argument('--duration', type=float, default=60,
+                             help='seconds to run')
+    parser_load.add_argument('--power', type=int, default=10000000,
+                             help='RAPL power of each domain in uW')
+    parser_load.add_argument('--pid', type=int,
+                             help='send SIGUSR1 to this thermald at the end')
+    parser_load.set_defaults(func=load)
+
+    args = parser.parse_args()
+    if args.command == 'create' and (args.zones < 1 or args.cdevs < 0
+                                     or args.hwmon_temps < 0):
+        sys.exit('Invalid count')
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
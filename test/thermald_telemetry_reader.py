@@ -0,0 +1,116 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# Read the thermald shared memory telemetry
+# With --telemetry, thermald rewrites /var/run/thermald/thermald.telemetry
+# with the current sensor temperatures, zone temperatures, cooling device
+# states and RAPL power after every engine tick. This maps the file and prints one JSON
+# object per line, as an example of a lock free reader.
+#
+# For example:
+# python3 thermald_telemetry_reader.py --interval 0.1 --count 10
+#
+# Sensors, zones and cooling devices are lists of [name, value] in the
+# order of the D-Bus indexes, names are not unique. Values: temperatures in
+# mC, cooling device states, RAPL power in uW with 0 when the domain is not
+# measured.
+
+import argparse
+import json
+import mmap
+import struct
+import sys
+import time
+
+TELEMETRY_VERSION = 1
+# Fixed part of the header, then seq and the fields it protects
+HEADER = struct.Struct('<8s6I7Q')
+VALUES = struct.Struct('<QQq4I')
+RAPL_DOMAINS = ['PACKAGE', 'DRAM', 'CORE', 'UNCORE']
+
+
+class TelemetryReader:
+    def __init__(self, file_name):
+        with open(file_name, 'rb') as f:
+            self.map = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+
+        (magic, version, self.name_size, max_sensors, max_zones, max_cdevs,
+         self.rapl_domains, self.sensor_temps, self.zone_temps,
+         self.cdev_states, self.rapl_power, self.sensor_names,
+         self.zone_names, self.cdev_names) = HEADER.unpack_from(self.map)
+        if magic != b'THDTELEM':
+            sys.exit('%s: not a thermald telemetry file' % file_name)
+        if version != TELEMETRY_VERSION:
+            sys.exit('%s: unsupported telemetry version %d' %
+                     (file_name, version))
+        self.layout_seq = None
+        self.names = None
+
+    def read_names(self, offset, count):
+        names = []
+        for i in range(count):
+            start = offset + i * self.name_size
+            name = self.map[start:start + self.name_size]
+            names.append(name.split(b'\0', 1)[0].decode(errors='replace'))
+        return names
+
+    def read_ints(self, fmt, offset, count):
+        return list(struct.unpack_from('<%d%s' % (count, fmt), self.map,
+                                       offset))
+
+    # Copy everything between two equal even seq values
+    def read(self):
+        while True:
+            seq = struct.unpack_from('<Q', self.map, HEADER.size)[0]
+            if seq & 1:
+                continue
+            (layout_seq, tick, time_ms, sensor_count, zone_count,
+             cdev_count, _) = VALUES.unpack_from(self.map, HEADER.size + 8)
+            if layout_seq != self.layout_seq:
+                names = (self.read_names(self.sensor_names, sensor_count),
+                         self.read_names(self.zone_names, zone_count),
+                         self.read_names(self.cdev_names, cdev_count))
+            else:
+                names = self.names
+            sensors = self.read_ints('i', self.sensor_temps, sensor_count)
+            zones = self.read_ints('i', self.zone_temps, zone_count)
+            cdevs = self.read_ints('i', self.cdev_states, cdev_count)
+            power = self.read_ints('I', self.rapl_power, self.rapl_domains)
+            if seq == struct.unpack_from('<Q', self.map, HEADER.size)[0]:
+                break
+
+        self.layout_seq = layout_seq
+        self.names = names
+        sensor_names, zone_names, cdev_names = names
+        return {'tick': tick, 'time_ms': time_ms,
+                'sensors': list(zip(sensor_names, sensors)),
+                'zones': list(zip(zone_names, zones)),
+                'cdevs': list(zip(cdev_names, cdevs)),
+                'rapl_power': dict(zip(RAPL_DOMAINS, power))}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Print thermald shared memory telemetry as JSON lines')
+    parser.add_argument('telemetry', nargs='?',
+                        default='/var/run/thermald/thermald.telemetry',
+                        help='telemetry file')
+    parser.add_argument('--interval', type=float, default=1.0,
+                        help='seconds between reads')
+    parser.add_argument('--count', type=int, default=1,
+                        help='number of reads, 0 for no limit')
+    args = parser.parse_args()
+
+    reader = TelemetryReader(args.telemetry)
+    reads = 0
+    while True:
+        sys.stdout.write(json.dumps(reader.read()) + '\n')
+        sys.stdout.flush()
+        reads += 1
+        if args.count and reads >= args.count:
+            break
+        time.sleep(args.interval)
+
+
+if __name__ == '__main__':
+    main()
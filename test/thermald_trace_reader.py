@@ -0,0 +1,104 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# Convert the thermald flight recorder trace to CSV or JSON
+# The trace is written by thermald to /var/run/thermald/thermald.trace, the
+# trace of the previous run is kept as thermald.trace.old. The file can be
+# read while thermald is running.
+#
+# For example:
+# python3 thermald_trace_reader.py /var/run/thermald/thermald.trace > trace.csv
+# python3 thermald_trace_reader.py --json /var/run/thermald/thermald.trace.old
+#
+# Columns:
+#   seq: record sequence number, gaps mean records were overwritten
+#   time_ns: CLOCK_MONOTONIC, realtime_ns: wall clock at the time of record
+#   event: sample, trip_on, trip_off, cdev_state, rapl_power
+#   id/name: sensor for sample, zone for trip, cdev for cdev_state,
+#            RAPL domain for rapl_power
+#   aux: trip index for trip events, zone for cdev_state
+#   value: temperature in mC, cdev state or power in uW
+
+import argparse
+import csv
+import json
+import struct
+import sys
+
+TRACE_VERSION = 1
+HEADER = struct.Struct('<8sIIIIQQqQ')
+RECORD = struct.Struct('<QqHHiq')
+NAME = struct.Struct('<HH28s')
+
+EVENTS = {1: 'sample', 2: 'trip_on', 3: 'trip_off', 4: 'cdev_state',
+          5: 'rapl_power'}
+NAME_SENSOR, NAME_ZONE, NAME_CDEV = 1, 2, 3
+EVENT_NAME_KIND = {1: NAME_SENSOR, 2: NAME_ZONE, 3: NAME_ZONE, 4: NAME_CDEV}
+RAPL_DOMAINS = {1: 'PACKAGE', 2: 'DRAM', 4: 'CORE', 8: 'UNCORE'}
+
+FIELDS = ['seq', 'time_ns', 'realtime_ns', 'event', 'id', 'name', 'aux',
+          'value']
+
+
+def read_trace(file_name):
+    with open(file_name, 'rb') as f:
+        data = f.read()
+
+    (magic, version, record_size, record_count, name_count, names_offset,
+     records_offset, realtime_offset, head) = HEADER.unpack_from(data)
+    if magic != b'THDTRACE':
+        sys.exit('%s: not a thermald trace' % file_name)
+    if version != TRACE_VERSION or record_size != RECORD.size:
+        sys.exit('%s: unsupported trace version %d' % (file_name, version))
+
+    names = {}
+    for i in range(name_count):
+        kind, nid, name = NAME.unpack_from(data, names_offset + i * NAME.size)
+        if not kind:
+            break
+        names[(kind, nid)] = name.split(b'\0', 1)[0].decode(errors='replace')
+
+    records = []
+    for slot in range(record_count):
+        rec = RECORD.unpack_from(data, records_offset + slot * record_size)
+        seq = rec[0]
+        # Skip empty slots and slots being written when the file was read
+        if not seq or (seq - 1) % record_count != slot:
+            continue
+        records.append(rec)
+    records.sort()
+
+    rows = []
+    for seq, time_ns, etype, eid, aux, value in records:
+        if etype == 5:
+            name = RAPL_DOMAINS.get(eid, '')
+        else:
+            name = names.get((EVENT_NAME_KIND.get(etype, 0), eid), '')
+        rows.append({'seq': seq, 'time_ns': time_ns,
+                     'realtime_ns': time_ns + realtime_offset,
+                     'event': EVENTS.get(etype, str(etype)), 'id': eid,
+                     'name': name, 'aux': aux, 'value': value})
+
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert thermald trace to CSV or JSON')
+    parser.add_argument('trace', help='trace file')
+    parser.add_argument('--json', action='store_true',
+                        help='output JSON instead of CSV')
+    args = parser.parse_args()
+
+    rows = read_trace(args.trace)
+    if args.json:
+        json.dump(rows, sys.stdout, indent=1)
+        sys.stdout.write('\n')
+    else:
+        writer = csv.DictWriter(sys.stdout, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+if __name__ == '__main__':
+    main()